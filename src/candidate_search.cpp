@@ -0,0 +1,259 @@
+#include "candidate_search.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+namespace
+{
+
+// target speeds in mph, the last one is the planner's cruise speed
+const double speeds[] = { 0, 5, 10, 15, 20, 25, 30, 35, 40, 45, 49.5 };
+const int num_speeds = sizeof(speeds) / sizeof(speeds[0]);
+const double max_speed = 49.5;
+
+// seconds checked beyond the reused points, with the anchor spacing of each
+const double horizons[] = { 2, 3, 4 };
+const double spacings[] = { 30, 40, 50 };
+const int num_horizons = sizeof(horizons) / sizeof(horizons[0]);
+const double max_horizon = 4;
+const int max_points = Telemetry::MAX_PATH + 200; // reused ones and max_horizon more
+
+// seconds the lateral motion to the lane centre takes with each horizon,
+// long enough for a full lane change to stay below max_lateral_jerk
+const double lateral_times[] = { 3, 4.5, 6 };
+
+// m/s^3 a lane change may take sideways, leaving the rest of the limit to
+// the speed changes and the curves of the road
+const double max_lateral_jerk = 5;
+
+// ego and every car are checked as a box with a safety margin around the car
+const double box_half_length = 4;
+const double box_half_width = 1.15;
+
+// only cars this close along the road can be reached within the horizon
+const double relevant_gap = 150;
+
+// cost weights next to the lane costs: giving up speed, driving close to
+// another car, checking less far ahead
+const double speed_weight = 2;
+const double proximity_weight = 3;
+const double comfortable_clearance = 20;
+const double horizon_weight = 0.02;
+
+}
+
+CandidateSearch::CandidateSearch(const HighwayMap &map)
+	: map(map), jmt(lateral_times, num_horizons), frenet_hint(-1), ramps(num_speeds * max_points)
+{
+}
+
+double CandidateSearch::reach()
+{
+	return relevant_gap;
+}
+
+int CandidateSearch::checks(int reused)
+{
+	return reused + (int)(max_horizon / .02);
+}
+
+// boxes of the cars close enough along the road to be reached
+void CandidateSearch::occupy(const Telemetry &j, const Prediction &traffic)
+{
+	near.clear();
+	for (int i = 0; i < traffic.size(); i++)
+	{
+		const Track &t = traffic.track(i);
+		double gap = t.s - j.s;
+		gap -= map.max_s * floor(gap / map.max_s + 0.5);
+		if (traffic.predicted(i) && fabs(gap) < relevant_gap && t.d >= 0 && t.d <= map.num_lanes * map.lane_width)
+		{
+			near.push_back(i);
+		}
+	}
+
+	int steps = min(traffic.steps(), checks(j.previous_path_size));
+	occupancy.reset(steps, (int)near.size());
+	for (size_t n = 0; n < near.size(); n++)
+	{
+		int i = near[n];
+		for (int c = 0; c < steps; c++)
+		{
+			OrientedBox box = { traffic.x(i, c), traffic.y(i, c), traffic.heading_x(i, c), traffic.heading_y(i, c),
+			                    box_half_length, box_half_width };
+			occupancy.set(c, (int)n, box);
+		}
+	}
+}
+
+void CandidateSearch::evaluate(Candidate &c, PathSpline &spline, const Telemetry &j, const PathStart &start,
+                               double ref_vel, const double *ramp, const Quintic &lateral, double T,
+                               const double *lane_cost) const
+{
+	int reused = start.reused;
+	int total = max(PATH_POINTS, reused + (int)(c.horizon / .02));
+	c.v.clear();
+	c.feasible = max_jerk(lateral, T) <= max_lateral_jerk;
+	c.final_speed = ref_vel;
+
+	// distance along the spline of the new points, the sent ones first
+	double distance[max_points];
+	double local_x[max_points];
+	double px[max_points];
+	double py[max_points];
+	int used = total - reused;
+	double travelled = 0;
+	for (int k = reused; k < total; k++)
+	{
+		double v = ramp[k - reused];
+		travelled += .02 * v;
+		distance[k - reused] = travelled;
+
+		if (k < PATH_POINTS)
+		{
+			c.v.push_back(v);
+			c.final_speed = v * 2.24;
+		}
+	}
+
+	// anchors spacing apart, on the lateral quintic when the car passes them
+	double ahead[3];
+	double offset[3];
+	int p = 0;
+	for (int a = 0; a < 3; a++)
+	{
+		ahead[a] = c.spacing * (a + 1);
+		while (p < used && distance[p] < ahead[a])
+		{
+			p++;
+		}
+		offset[a] = lateral.position(min((p + 1) * .02, T));
+	}
+	spline.fit(map, start, ahead, offset);
+
+	spline.local_x_at(distance, used, local_x);
+	spline.points(local_x, used, px, py);
+	int emitted = max(0, PATH_POINTS - reused);
+	c.x.assign(px, px + emitted);
+	c.y.assign(py, py + emitted);
+
+	double clearance = comfortable_clearance;
+	OrientedBox ego = { j.x, j.y, cos(start.yaw), sin(start.yaw), box_half_length, box_half_width };
+	for (int k = 0; k < total && c.feasible; k++)
+	{
+		double x = k < reused ? j.previous_path_x[k] : px[k - reused];
+		double y = k < reused ? j.previous_path_y[k] : py[k - reused];
+
+		// ego heading along the chord from the last point, kept while
+		// standing still
+		double dx = x - ego.x;
+		double dy = y - ego.y;
+		double step = sqrt(dx * dx + dy * dy);
+		if (step > 0.01)
+		{
+			ego.cos = dx / step;
+			ego.sin = dy / step;
+		}
+		ego.x = x;
+		ego.y = y;
+		if (k < occupancy.steps())
+		{
+			c.feasible = occupancy.clear(k, ego, clearance);
+		}
+	}
+
+	c.cost = lane_cost[c.lane]
+		+ speed_weight * (max_speed - c.speed) / max_speed
+		+ proximity_weight * (comfortable_clearance - clearance) / comfortable_clearance
+		+ horizon_weight * (max_horizon - c.horizon);
+}
+
+const Candidate &CandidateSearch::search(const Telemetry &j, const PathStart &start, const Prediction &traffic,
+                                         int current_lane, double ref_vel, double accel,
+                                         const double *lane_cost, WorkerPool *pool)
+{
+	// the candidate vectors keep their capacity from tick to tick
+	int lo = max(current_lane - 1, 0);
+	int hi = min(current_lane + 1, map.num_lanes - 1);
+	int n = (hi - lo + 1) * num_horizons * num_speeds;
+	all.resize(n);
+	for (int k = (int)splines.size(); k < n; k++)
+	{
+		splines.push_back(unique_ptr<PathSpline>(new PathSpline));
+	}
+	int i = 0;
+	for (int lane = lo; lane <= hi; lane++)
+	{
+		for (int h = 0; h < num_horizons; h++)
+		{
+			for (int v = 0; v < num_speeds; v++)
+			{
+				Candidate &c = all[i++];
+				c.lane = lane;
+				c.horizon = horizons[h];
+				c.spacing = spacings[h];
+				c.speed = min(speeds[v], max_speed);
+			}
+		}
+	}
+
+	// the speeds only depend on the target speed, the same for every lane and horizon
+	int longest = max(PATH_POINTS, start.reused + (int)(max_horizon / .02)) - start.reused;
+	for (int v = 0; v < num_speeds; v++)
+	{
+		profile.plan(ref_vel / 2.24, accel, min(speeds[v], max_speed) / 2.24, NULL, longest,
+		             &ramps[v * max_points]);
+	}
+
+	// lateral offset of the start in the frame of the fitted map, where the
+	// anchors are placed. The anchors only fix positions, the spline keeps
+	// the heading of the previous path, so the motion starts at rest.
+	double d0 = map.getFrenetSmooth(start.x, start.y, start.yaw, frenet_hint)[1];
+	const double from[3] = { d0, 0, 0 };
+	lateral.resize((hi - lo + 1) * num_horizons);
+	for (int lane = lo; lane <= hi; lane++)
+	{
+		const double to[3] = { map.lane_center(lane), 0, 0 };
+		for (int h = 0; h < num_horizons; h++)
+		{
+			lateral[(lane - lo) * num_horizons + h] = jmt[h].solve(from, to);
+		}
+	}
+
+	occupy(j, traffic);
+
+	auto task = [&](int k)
+	{
+		evaluate(all[k], *splines[k], j, start, ref_vel, &ramps[(k % num_speeds) * max_points],
+		         lateral[k / num_speeds], lateral_times[(k / num_speeds) % num_horizons], lane_cost);
+	};
+	if (pool)
+	{
+		pool->run(n, task);
+	}
+	else
+	{
+		for (int k = 0; k < n; k++)
+		{
+			task(k);
+		}
+	}
+
+	const Candidate *best = NULL;
+	const Candidate *fallback = NULL;
+	for (int k = 0; k < n; k++)
+	{
+		const Candidate &c = all[k];
+		if (c.feasible && (!best || c.cost < best->cost))
+		{
+			best = &c;
+		}
+		// braking in lane with the shortest horizon is the least bad way out
+		if (c.lane == current_lane && c.speed == 0 && (!fallback || c.horizon < fallback->horizon))
+		{
+			fallback = &c;
+		}
+	}
+	return best ? *best : *fallback;
+}
@@ -0,0 +1,89 @@
+#ifndef CANDIDATE_SEARCH_H
+#define CANDIDATE_SEARCH_H
+
+#include <memory>
+#include <vector>
+#include "collision.h"
+#include "highway_map.h"
+#include "jmt.h"
+#include "path_generator.h"
+#include "prediction.h"
+#include "telemetry.h"
+#include "velocity_profile.h"
+#include "worker_pool.h"
+
+// One way to continue the previous path: a lane, a speed to accelerate or
+// brake to and how far ahead it is checked against the traffic.
+struct Candidate
+{
+	int lane;
+	double speed;        // mph the candidate ramps towards
+	double horizon;      // s checked beyond the reused points
+	double spacing;      // m between the spline anchors
+
+	bool feasible;       // no predicted car box overlaps the ego box
+	double cost;
+	double final_speed;  // mph at the last point that is sent
+
+	// points appended to the reused previous path, with their speed in m/s
+	std::vector<double> x;
+	std::vector<double> y;
+	std::vector<double> v;
+};
+
+// Generates candidates for the lanes next to the current one, several target
+// speeds and several horizons, checks them all against the predicted traffic
+// and returns the cheapest feasible one.
+class CandidateSearch
+{
+public:
+	explicit CandidateSearch(const HighwayMap &map);
+
+	// ref_vel in mph and accel in m/s^2 are the state at the end of the reused
+	// points, every candidate ramps from there to its speed within the
+	// limits of the velocity profile. lane_cost is the lane choice cost of
+	// this tick for every lane. Without a feasible candidate the keep-lane
+	// candidate braking hardest is returned.
+	// pool may be NULL to evaluate on the calling thread.
+	// traffic must be predicted at the 0.02 s steps of the points, checks()
+	// of them, for the cars within reach() of the car.
+	const Candidate &search(const Telemetry &j, const PathStart &start, const Prediction &traffic,
+	                        int current_lane, double ref_vel, double accel, const double *lane_cost,
+	                        WorkerPool *pool);
+
+	const std::vector<Candidate> &candidates() const { return all; }
+
+	// points of a sent path, the rest of a candidate is only checked
+	static const int PATH_POINTS = 80;
+
+	// traffic is checked at every point, up to the longest horizon beyond
+	// the reused ones
+	static int checks(int reused);
+	// distance along the road beyond which cars are ignored
+	static double reach();
+
+private:
+	const HighwayMap &map;
+	std::vector<Candidate> all;
+	std::vector<std::unique_ptr<PathSpline> > splines; // one per candidate, reused
+
+	// jerk minimizing lateral motion from the start to the lane centre, one
+	// per lane and horizon, which places the anchors of the splines
+	JmtTable jmt;
+	std::vector<Quintic> lateral;
+	int frenet_hint;
+
+	// speeds of the new points for every target speed, computed once a search
+	VelocityProfile profile;
+	std::vector<double> ramps;
+
+	// predicted traffic at every checked point, cars out of reach left out
+	TrafficOccupancy occupancy;
+	std::vector<int> near;
+
+	void occupy(const Telemetry &j, const Prediction &traffic);
+	void evaluate(Candidate &c, PathSpline &spline, const Telemetry &j, const PathStart &start, double ref_vel,
+	              const double *ramp, const Quintic &lateral, double T, const double *lane_cost) const;
+};
+
+#endif /* CANDIDATE_SEARCH_H */
@@ -0,0 +1,137 @@
+#include "collision.h"
+#include <algorithm>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+TrafficOccupancy::TrafficOccupancy() : num_steps(0), num_boxes(0), stride(0)
+{
+}
+
+void TrafficOccupancy::reset(int steps, int boxes)
+{
+	num_steps = steps;
+	num_boxes = boxes;
+	stride = (boxes + 1) & ~1;
+
+	size_t n = (size_t)steps * stride;
+	x.resize(n);
+	y.resize(n);
+	dir_x.resize(n);
+	dir_y.resize(n);
+	half_length.resize(n);
+	half_width.resize(n);
+
+	if (stride != boxes)
+	{
+		for (int step = 0; step < steps; step++)
+		{
+			OrientedBox nowhere = { 1e9, 1e9, 1, 0, 0, 0 };
+			set(step, boxes, nowhere);
+		}
+	}
+}
+
+void TrafficOccupancy::set(int step, int box, const OrientedBox &b)
+{
+	size_t k = (size_t)step * stride + box;
+	x[k] = b.x;
+	y[k] = b.y;
+	dir_x[k] = b.cos;
+	dir_y[k] = b.sin;
+	half_length[k] = b.half_length;
+	half_width[k] = b.half_width;
+}
+
+// Two rectangles are apart when their centres are further apart along one of
+// the four edge directions than the sum of their projected half extents.
+bool TrafficOccupancy::clear(int step, const OrientedBox &ego, double &clearance) const
+{
+	size_t row = (size_t)step * stride;
+	int i = 0;
+#ifdef __SSE2__
+	const __m128d sign = _mm_set1_pd(-0.0);
+	const __m128d ex = _mm_set1_pd(ego.x);
+	const __m128d ey = _mm_set1_pd(ego.y);
+	const __m128d ec = _mm_set1_pd(ego.cos);
+	const __m128d es = _mm_set1_pd(ego.sin);
+	const __m128d el = _mm_set1_pd(ego.half_length);
+	const __m128d ew = _mm_set1_pd(ego.half_width);
+	const __m128d zero = _mm_setzero_pd();
+	__m128d nearest = _mm_set1_pd(clearance);
+	for (; i < stride; i += 2)
+	{
+		size_t k = row + i;
+		__m128d dx = _mm_sub_pd(ex, _mm_loadu_pd(&x[k]));
+		__m128d dy = _mm_sub_pd(ey, _mm_loadu_pd(&y[k]));
+		__m128d cc = _mm_loadu_pd(&dir_x[k]);
+		__m128d cs = _mm_loadu_pd(&dir_y[k]);
+		__m128d cl = _mm_loadu_pd(&half_length[k]);
+		__m128d cw = _mm_loadu_pd(&half_width[k]);
+
+		// |cos| and |sin| of the angle between the two headings
+		__m128d rc = _mm_andnot_pd(sign, _mm_add_pd(_mm_mul_pd(cc, ec), _mm_mul_pd(cs, es)));
+		__m128d rs = _mm_andnot_pd(sign, _mm_sub_pd(_mm_mul_pd(cs, ec), _mm_mul_pd(cc, es)));
+
+		// along and across ego
+		__m128d p = _mm_andnot_pd(sign, _mm_add_pd(_mm_mul_pd(dx, ec), _mm_mul_pd(dy, es)));
+		__m128d r = _mm_add_pd(el, _mm_add_pd(_mm_mul_pd(cl, rc), _mm_mul_pd(cw, rs)));
+		__m128d apart = _mm_cmpgt_pd(p, r);
+		p = _mm_andnot_pd(sign, _mm_sub_pd(_mm_mul_pd(dy, ec), _mm_mul_pd(dx, es)));
+		r = _mm_add_pd(ew, _mm_add_pd(_mm_mul_pd(cl, rs), _mm_mul_pd(cw, rc)));
+		apart = _mm_or_pd(apart, _mm_cmpgt_pd(p, r));
+
+		// along and across the car
+		__m128d along = _mm_andnot_pd(sign, _mm_add_pd(_mm_mul_pd(dx, cc), _mm_mul_pd(dy, cs)));
+		__m128d reach = _mm_add_pd(cl, _mm_add_pd(_mm_mul_pd(el, rc), _mm_mul_pd(ew, rs)));
+		apart = _mm_or_pd(apart, _mm_cmpgt_pd(along, reach));
+		p = _mm_andnot_pd(sign, _mm_sub_pd(_mm_mul_pd(dy, cc), _mm_mul_pd(dx, cs)));
+		r = _mm_add_pd(cw, _mm_add_pd(_mm_mul_pd(el, rs), _mm_mul_pd(ew, rc)));
+		__m128d beside = _mm_cmpgt_pd(p, r);
+		apart = _mm_or_pd(apart, beside);
+
+		if (_mm_movemask_pd(apart) != 3)
+		{
+			return false;
+		}
+
+		// gap to the cars in line with ego
+		__m128d gap = _mm_max_pd(zero, _mm_sub_pd(along, reach));
+		gap = _mm_or_pd(_mm_and_pd(beside, nearest), _mm_andnot_pd(beside, gap));
+		nearest = _mm_min_pd(nearest, gap);
+	}
+	nearest = _mm_min_pd(nearest, _mm_unpackhi_pd(nearest, nearest));
+	clearance = _mm_cvtsd_f64(nearest);
+#endif
+	for (; i < num_boxes; i++)
+	{
+		size_t k = row + i;
+		double dx = ego.x - x[k];
+		double dy = ego.y - y[k];
+		double cc = dir_x[k];
+		double cs = dir_y[k];
+		double cl = half_length[k];
+		double cw = half_width[k];
+
+		double rc = fabs(cc * ego.cos + cs * ego.sin);
+		double rs = fabs(cs * ego.cos - cc * ego.sin);
+
+		bool apart = fabs(dx * ego.cos + dy * ego.sin) > ego.half_length + cl * rc + cw * rs
+			|| fabs(dy * ego.cos - dx * ego.sin) > ego.half_width + cl * rs + cw * rc;
+		double along = fabs(dx * cc + dy * cs);
+		double reach = cl + ego.half_length * rc + ego.half_width * rs;
+		bool beside = fabs(dy * cc - dx * cs) > cw + ego.half_length * rs + ego.half_width * rc;
+		if (!apart && !beside && along <= reach)
+		{
+			return false;
+		}
+		if (!beside)
+		{
+			clearance = min(clearance, max(0.0, along - reach));
+		}
+	}
+	return true;
+}
@@ -0,0 +1,50 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <vector>
+
+// Rectangle centred at x,y with its length along the unit heading (cos, sin).
+struct OrientedBox
+{
+	double x;
+	double y;
+	double cos;
+	double sin;
+	double half_length;
+	double half_width;
+};
+
+// Boxes of the predicted traffic indexed by time step, one row of boxes per
+// step, as columns so an ego box is tested against two cars at a time.
+class TrafficOccupancy
+{
+public:
+	TrafficOccupancy();
+
+	// room for boxes per step, contents undefined until set()
+	void reset(int steps, int boxes);
+
+	void set(int step, int box, const OrientedBox &b);
+
+	int steps() const { return num_steps; }
+	int boxes() const { return num_boxes; }
+
+	// Separating axis test of ego against every box of the step, false at the
+	// first overlap. Otherwise clearance is lowered to the smallest gap along
+	// a box that ego overlaps sideways, the room left before running into it.
+	bool clear(int step, const OrientedBox &ego, double &clearance) const;
+
+private:
+	int num_steps;
+	int num_boxes;
+	int stride; // num_boxes rounded up to a pair, the padding boxes are far away
+
+	std::vector<double> x;
+	std::vector<double> y;
+	std::vector<double> dir_x; // heading
+	std::vector<double> dir_y;
+	std::vector<double> half_length;
+	std::vector<double> half_width;
+};
+
+#endif /* COLLISION_H */
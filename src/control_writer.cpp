@@ -0,0 +1,255 @@
+#include "control_writer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+
+using namespace std;
+
+static const double pow10_table[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// powers of ten that are exact in a long double with at least a 64 bit
+// mantissa: x87 extended precision, or IEEE quad as on aarch64
+static const long double pow10_long[] = {
+	1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L,
+	1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+};
+
+ControlWriter::ControlWriter(int expected_points) : used(0)
+{
+	// two arrays of up to 24 chars per number plus the frame around them
+	buffer.resize(2 * 25 * expected_points + 64);
+}
+
+void ControlWriter::append(const char *text, size_t n)
+{
+	if (used + n > buffer.size())
+	{
+		buffer.resize(2 * (used + n));
+	}
+	memcpy(&buffer[used], text, n);
+	used += n;
+}
+
+static int write_fixed(uint64_t m, int f, bool negative, char *out);
+
+// value == m / 10^f after correct rounding. The quotient is rounded once to
+// the long double mantissa and once more to double; that second rounding can
+// only go wrong when the first one lands exactly halfway between two
+// doubles, and only then the parser decides.
+static bool reads_back(uint64_t m, int f, double value)
+{
+	long double q = (long double)m / pow10_long[f];
+	double d = (double)q;
+	// q is halfway exactly when d + 2 (q - d) is the neighbouring double
+	long double rest = q - (long double)d;
+	long double twice = (long double)d + 2*rest;
+	if (rest == 0 || (long double)(double)twice != twice)
+	{
+		return d == value;
+	}
+	char text[32];
+	text[write_fixed(m, f, false, text)] = '\0';
+	return strtod(text, NULL) == value;
+}
+
+// m = value * 10^f rounded to an integer, true if m / 10^f reads back as value.
+// The product is rounded too, so the integer nearest to the exact value * 10^f
+// can be one away from it when the product lies within its rounding error of
+// a half. No other integer can read back when the nearest does not. Below
+// 2^53 both m and 10^f are exact doubles and one division decides it.
+static bool decimal_candidate(double value, int f, uint64_t &m)
+{
+	static const int order[] = { 0, -1, 1 };
+	if (f <= 22)
+	{
+		double scaled = value * pow10_table[f];
+		if (scaled < 9007199254740991.0)
+		{
+			double rounded = floor(scaled + 0.5);
+			double off = scaled - rounded;
+			if (rounded / pow10_table[f] == value)
+			{
+				m = (uint64_t)rounded;
+				return true;
+			}
+			if (0.5 - fabs(off) > scaled * DBL_EPSILON)
+			{
+				return false;
+			}
+			double next = rounded + (off < 0 ? -1 : 1);
+			if (next >= 0 && next / pow10_table[f] == value)
+			{
+				m = (uint64_t)next;
+				return true;
+			}
+			return false;
+		}
+	}
+	uint64_t rounded = (uint64_t)(value * pow10_long[f] + 0.5L);
+	for (int k = 0; k < 3; k++)
+	{
+		m = rounded + order[k];
+		if (reads_back(m, f, value))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// fewest significant digits in %g notation that read back, for the values
+// outside the range of the decimal search. More digits never move the
+// literal further away, so the ones that read back are a range up to 17.
+static int format_general(double value, char *out)
+{
+	int lo = 1;
+	int hi = 17;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		snprintf(out, 32, "%.*g", mid, value);
+		if (strtod(out, NULL) == value)
+		{
+			hi = mid;
+		}
+		else
+		{
+			lo = mid + 1;
+		}
+	}
+	return snprintf(out, 32, "%.*g", hi, value);
+}
+
+// m with the decimal point f digits from the right
+static int write_fixed(uint64_t m, int f, bool negative, char *out)
+{
+	char digits[24];
+	int n = 0;
+	do
+	{
+		digits[n++] = '0' + (char)(m % 10);
+		m /= 10;
+	} while (m != 0);
+	while (n <= f)
+	{
+		digits[n++] = '0';
+	}
+
+	int len = 0;
+	if (negative)
+	{
+		out[len++] = '-';
+	}
+	for (int k = n - 1; k >= 0; k--)
+	{
+		out[len++] = digits[k];
+		if (k == f && f > 0)
+		{
+			out[len++] = '.';
+		}
+	}
+	return len;
+}
+
+int ControlWriter::format_double(double value, char *out)
+{
+	if (!isfinite(value))
+	{
+		memcpy(out, "null", 4);
+		return 4;
+	}
+
+	double magnitude = fabs(value);
+#if LDBL_MANT_DIG >= 64
+	if (magnitude < 1e15 && magnitude >= 1e-6)
+	{
+		// decimal exponent of the leading digit, being off by one near powers
+		// of ten only shifts which candidates are tried
+		int e = (int)floor(log10(magnitude));
+
+		// 17 significant digits always read back. Rounding to more decimals
+		// never moves the literal further away, so the decimals that read back
+		// form a range [f_min, f17]. Try 15 digits first, which still fits the
+		// cheap double check: if it reads back, binary search below it,
+		// otherwise the answer is 16 or 17 digits.
+		int f17 = 16 - e;
+		if (f17 < 2)
+		{
+			f17 = 2;
+		}
+		int f15 = f17 - 2;
+		uint64_t m;
+		int f;
+		if (decimal_candidate(magnitude, f15, m))
+		{
+			int lo = 0;
+			f = f15;
+			while (lo < f)
+			{
+				int mid = (lo + f) / 2;
+				uint64_t m_mid;
+				if (decimal_candidate(magnitude, mid, m_mid))
+				{
+					f = mid;
+					m = m_mid;
+				}
+				else
+				{
+					lo = mid + 1;
+				}
+			}
+			return write_fixed(m, f, value < 0, out);
+		}
+		for (f = f15 + 1; f <= f17; f++)
+		{
+			if (decimal_candidate(magnitude, f, m))
+			{
+				return write_fixed(m, f, value < 0, out);
+			}
+		}
+	}
+#endif
+
+	return format_general(value, out);
+}
+
+void ControlWriter::append_array(const double *values, int n)
+{
+	append("[", 1);
+	char number[32];
+	for (int i = 0; i < n; i++)
+	{
+		if (i > 0)
+		{
+			append(",", 1);
+		}
+		append(number, format_double(values[i], number));
+	}
+	append("]", 1);
+}
+
+void ControlWriter::write(const double *next_x, const double *next_y, int n)
+{
+	used = 0;
+
+	static const char head[] = "42[\"control\",{\"next_x\":";
+	static const char middle[] = ",\"next_y\":";
+	static const char tail[] = "}]";
+
+	append(head, sizeof(head) - 1);
+	append_array(next_x, n);
+	append(middle, sizeof(middle) - 1);
+	append_array(next_y, n);
+	append(tail, sizeof(tail) - 1);
+}
+
+void ControlWriter::write(const vector<double> &next_x, const vector<double> &next_y)
+{
+	write(next_x.data(), next_y.data(), (int)next_x.size());
+}
@@ -0,0 +1,32 @@
+#ifndef CONTROL_WRITER_H
+#define CONTROL_WRITER_H
+
+#include <cstddef>
+#include <vector>
+
+// Builds the 42["control",{"next_x":[...],"next_y":[...]}] reply in a buffer
+// that is kept between messages, so steady state sends do not allocate.
+class ControlWriter
+{
+public:
+	explicit ControlWriter(int expected_points = 256);
+
+	void write(const double *next_x, const double *next_y, int n);
+	void write(const std::vector<double> &next_x, const std::vector<double> &next_y);
+
+	const char *data() const { return &buffer[0]; }
+	size_t length() const { return used; }
+
+	// decimal with the fewest significant digits that reads back to the same double,
+	// returns the number of chars written. out must hold at least 32 chars.
+	static int format_double(double value, char *out);
+
+private:
+	std::vector<char> buffer;
+	size_t used;
+
+	void append(const char *text, size_t n);
+	void append_array(const double *values, int n);
+};
+
+#endif /* CONTROL_WRITER_H */
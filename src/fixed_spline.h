@@ -0,0 +1,142 @@
+/*
+ * fixed_spline.h
+ *
+ * Natural cubic spline through exactly N points, N known at compile time.
+ * Everything is in std::arrays of the object and every loop runs N or N + 1
+ * times, so with optimization the fit and the evaluation unroll to straight
+ * code: no heap, no search, no branches on the data.
+ *
+ * Results are bit for bit those of tk::spline with its default boundary
+ * conditions, which stays the one to use for other boundaries or a number of
+ * points only known at run time.
+ */
+
+#ifndef TK_FIXED_SPLINE_H
+#define TK_FIXED_SPLINE_H
+
+#include <array>
+#include <cassert>
+#include "spline_pieces.h"
+
+// same unnamed namespace as spline.h, so tk:: names both
+namespace
+{
+
+namespace tk
+{
+
+template<int N>
+class fixed_spline
+{
+	static_assert(N >= 3, "a cubic spline needs at least 3 points");
+
+public:
+	typedef std::array<double, N> points;
+
+	fixed_spline() : m_x(), m_y() {}
+
+	// x strictly increasing
+	void set_points(const double *x, const double *y);
+	void set_points(const points &x, const points &y) { set_points(x.data(), y.data()); }
+
+	double operator()(double x) const;
+
+	// Values at n x and, where dy and ddy are not NULL, the first and second
+	// derivatives, the same as operator() for each x. Fastest for increasing x.
+	void eval_sorted(const double *x, int n, double *y, double *dy = 0, double *ddy = 0) const
+	{
+		spline_pieces pieces = { m_x.data(), N, m_origin.data(), m_py.data(), m_a.data(), m_b.data(), m_c.data() };
+		eval_pieces(pieces, x, n, y, dy, ddy);
+	}
+
+	static int size() { return N; }
+
+private:
+	points m_x;
+	points m_y;
+
+	// Piece k of N + 1 is y + h*(c + h*(b + h*a)) with h = x - origin: the
+	// left extrapolation, the N - 1 segments, the right extrapolation.
+	std::array<double, N + 1> m_origin;
+	std::array<double, N + 1> m_py;
+	std::array<double, N + 1> m_a;
+	std::array<double, N + 1> m_b;
+	std::array<double, N + 1> m_c;
+};
+
+template<int N>
+void fixed_spline<N>::set_points(const double *x, const double *y)
+{
+	for (int i = 0; i < N; i++)
+	{
+		m_x[i] = x[i];
+		m_y[i] = y[i];
+	}
+	for (int i = 0; i < N - 1; i++)
+	{
+		assert(x[i] < x[i + 1]);
+	}
+
+	// system for the b[] with zero second derivatives at both ends, in the
+	// rows of tk::spline
+	points lower, diag, upper, scale, b;
+	for (int i = 1; i < N - 1; i++)
+	{
+		lower[i] = 1.0 / 3.0 * (x[i] - x[i - 1]);
+		diag[i] = 2.0 / 3.0 * (x[i + 1] - x[i - 1]);
+		upper[i] = 1.0 / 3.0 * (x[i + 1] - x[i]);
+		b[i] = (y[i + 1] - y[i]) / (x[i + 1] - x[i]) - (y[i] - y[i - 1]) / (x[i] - x[i - 1]);
+	}
+	diag[0] = 2.0;
+	upper[0] = 0.0;
+	b[0] = 0.0;
+	diag[N - 1] = 2.0;
+	lower[N - 1] = 0.0;
+	b[N - 1] = 0.0;
+	thomas_solve(lower.data(), diag.data(), upper.data(), scale.data(), b.data(), N);
+
+	// the segments are pieces 1 to N - 1
+	for (int i = 0; i < N - 1; i++)
+	{
+		double h = x[i + 1] - x[i];
+		m_origin[i + 1] = x[i];
+		m_py[i + 1] = y[i];
+		m_a[i + 1] = 1.0 / 3.0 * (b[i + 1] - b[i]) / h;
+		m_b[i + 1] = b[i];
+		m_c[i + 1] = (y[i + 1] - y[i]) / h - 1.0 / 3.0 * (2.0 * b[i] + b[i + 1]) * h;
+	}
+
+	// the extrapolations are quadratic, pieces with a == 0
+	m_origin[0] = x[0];
+	m_py[0] = y[0];
+	m_a[0] = 0.0;
+	m_b[0] = b[0];
+	m_c[0] = m_c[1];
+
+	double h = x[N - 1] - x[N - 2];
+	m_origin[N] = x[N - 1];
+	m_py[N] = y[N - 1];
+	m_a[N] = 0.0;
+	m_b[N] = b[N - 1];
+	m_c[N] = 3.0 * m_a[N - 1] * h * h + 2.0 * m_b[N - 1] * h + m_c[N - 1];
+}
+
+template<int N>
+double fixed_spline<N>::operator()(double x) const
+{
+	// The piece is the number of points left of x. At x == m_x[0] that is
+	// the left extrapolation instead of the first segment, both give y[0].
+	int k = 0;
+	for (int i = 0; i < N; i++)
+	{
+		k += m_x[i] < x;
+	}
+	double h = x - m_origin[k];
+	return ((m_a[k] * h + m_b[k]) * h + m_c[k]) * h + m_py[k];
+}
+
+} // namespace tk
+
+} // namespace
+
+#endif /* TK_FIXED_SPLINE_H */
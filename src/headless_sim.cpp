@@ -0,0 +1,261 @@
+// Runs the planner in closed loop against the built-in HighwaySimulator,
+// many independent runs in parallel, and reports planner cost together with
+// the safety metrics of every run.
+//
+//   ./headless_sim --runs 64 --laps 2 --threads 8
+//
+// --candidates plans with the trajectory candidate search, --workers N splits
+// its evaluation over N threads inside every run.
+//
+// With --frames every tick goes through the websocket text protocol
+// (telemetry frame -> parse_telemetry -> Planner -> ControlWriter -> control
+// frame), otherwise the planner reads the simulator's Telemetry directly.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "control_writer.h"
+#include "highway_map.h"
+#include "planner.h"
+#include "simulator.h"
+#include "telemetry.h"
+#include "worker_pool.h"
+
+using namespace std;
+
+namespace
+{
+
+struct Options
+{
+	string map_file;
+	int runs;
+	int laps;
+	int threads;
+	int workers;
+	bool frames;
+	bool candidates;
+	SimulatorConfig sim;
+	LaneCostModel costs;
+
+	Options() : map_file("../data/highway_map.csv"), runs(8), laps(1), threads(0), workers(1), frames(false),
+		candidates(false), costs(default_lane_costs()) {}
+};
+
+struct RunResult
+{
+	SimulatorMetrics metrics;
+	int laps;
+	long ticks;
+	bool finished;           // reached the lap count before the time limit
+	vector<double> tick_us;  // planner cost per tick, parse and write included with --frames
+};
+
+RunResult run(const HighwayMap &map, const Options &options, unsigned seed)
+{
+	SimulatorConfig config = options.sim;
+	config.seed = seed;
+	HighwaySimulator sim(map, config);
+	Planner planner(map);
+	planner.costs = options.costs;
+	planner.candidates = options.candidates;
+	unique_ptr<WorkerPool> pool;
+	if (options.workers > 1)
+	{
+		pool.reset(new WorkerPool(options.workers));
+		planner.pool = pool.get();
+	}
+	unique_ptr<Telemetry> telemetry(new Telemetry);
+	ControlWriter control(Telemetry::MAX_PATH);
+	string frame;
+
+	RunResult result;
+	result.ticks = 0;
+	result.finished = false;
+
+	// no run may take longer than the laps at 5 m/s
+	double tick_time = config.points_per_tick * 0.02;
+	long max_ticks = (long)(options.laps * map.max_s / (5 * tick_time));
+	result.tick_us.reserve(max_ticks);
+
+	while (result.ticks < max_ticks && sim.laps() < options.laps)
+	{
+		chrono::steady_clock::time_point start;
+		if (options.frames)
+		{
+			write_telemetry_frame(sim.telemetry(), frame);
+			start = chrono::steady_clock::now();
+			parse_telemetry(frame.data(), frame.size(), *telemetry);
+			const Trajectory &path = planner.step(*telemetry);
+			control.write(path.x, path.y, path.size);
+			chrono::steady_clock::time_point end = chrono::steady_clock::now();
+			result.tick_us.push_back(chrono::duration<double, micro>(end - start).count());
+			sim.advance(control.data(), control.length());
+		}
+		else
+		{
+			start = chrono::steady_clock::now();
+			const Trajectory &path = planner.step(sim.telemetry());
+			chrono::steady_clock::time_point end = chrono::steady_clock::now();
+			result.tick_us.push_back(chrono::duration<double, micro>(end - start).count());
+			sim.advance(path.x, path.y, path.size);
+		}
+		result.ticks++;
+	}
+
+	result.metrics = sim.metrics();
+	result.laps = sim.laps();
+	result.finished = result.laps >= options.laps;
+	return result;
+}
+
+bool parse_options(int argc, char *argv[], Options &options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if (arg == "--frames")
+		{
+			options.frames = true;
+		}
+		else if (arg == "--candidates")
+		{
+			options.candidates = true;
+		}
+		else if (arg == "--workers" && has_value)
+		{
+			options.workers = atoi(argv[++i]);
+		}
+		else if (arg == "--runs" && has_value)
+		{
+			options.runs = atoi(argv[++i]);
+		}
+		else if (arg == "--laps" && has_value)
+		{
+			options.laps = atoi(argv[++i]);
+		}
+		else if (arg == "--threads" && has_value)
+		{
+			options.threads = atoi(argv[++i]);
+		}
+		else if (arg == "--cars" && has_value)
+		{
+			options.sim.cars = atoi(argv[++i]);
+		}
+		else if (arg == "--seed" && has_value)
+		{
+			options.sim.seed = (unsigned)atoi(argv[++i]);
+		}
+		else if (arg == "--map" && has_value)
+		{
+			options.map_file = argv[++i];
+		}
+		else if (arg == "--costs" && has_value)
+		{
+			string error;
+			if (!options.costs.load(argv[++i], error))
+			{
+				cerr << error << endl;
+				return false;
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return options.runs > 0 && options.laps > 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	Options options;
+	if (!parse_options(argc, argv, options))
+	{
+		cerr << "usage: headless_sim [--runs N] [--laps N] [--threads N] [--cars N] [--seed N] [--frames] [--candidates] [--workers N] [--map file] [--costs file]" << endl;
+		return 2;
+	}
+	if (options.threads <= 0)
+	{
+		options.threads = max(1, (int)thread::hardware_concurrency());
+	}
+
+	HighwayMap map;
+	if (!map.load(options.map_file))
+	{
+		cerr << "Failed to read " << options.map_file << endl;
+		return 1;
+	}
+
+	// runs are handed out to the workers one at a time, run i uses seed + i
+	vector<RunResult> results(options.runs);
+	atomic<int> next_run(0);
+	mutex print_lock;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	vector<thread> workers;
+	for (int w = 0; w < min(options.threads, options.runs); w++)
+	{
+		workers.push_back(thread([&]() {
+			int i;
+			while ((i = next_run.fetch_add(1)) < options.runs)
+			{
+				results[i] = run(map, options, options.sim.seed + i);
+				const RunResult &r = results[i];
+				lock_guard<mutex> lock(print_lock);
+				printf("run %3d  laps %d%s  ticks %6ld  collisions %d  speeding %d  accel %d  jerk %d  offroad %d  max %.1f mph\n",
+					i, r.laps, r.finished ? "" : " (timeout)", r.ticks, r.metrics.collisions,
+					r.metrics.speeding_steps, r.metrics.accel_steps, r.metrics.jerk_steps,
+					r.metrics.offroad_steps, r.metrics.max_speed * 2.23694);
+			}
+		}));
+	}
+	for (size_t w = 0; w < workers.size(); w++)
+	{
+		workers[w].join();
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	long ticks = 0;
+	int laps = 0;
+	int clean = 0;
+	double distance = 0;
+	double steps = 0;
+	vector<double> tick_us;
+	for (int i = 0; i < options.runs; i++)
+	{
+		const RunResult &r = results[i];
+		const SimulatorMetrics &m = r.metrics;
+		ticks += r.ticks;
+		laps += r.laps;
+		distance += m.distance;
+		steps += m.steps;
+		clean += r.finished && m.collisions == 0 && m.speeding_steps == 0 && m.accel_steps == 0 &&
+			m.jerk_steps == 0 && m.offroad_steps == 0;
+		tick_us.insert(tick_us.end(), r.tick_us.begin(), r.tick_us.end());
+	}
+
+	printf("\n%d runs, %d laps, %ld ticks in %.2f s on %d threads (%.0f laps/hour)\n",
+		options.runs, laps, ticks, seconds, (int)workers.size(), laps * 3600 / seconds);
+	printf("clean runs %d/%d, mean speed %.1f mph\n",
+		clean, options.runs, steps > 0 ? distance / (steps * 0.02) * 2.23694 : 0.0);
+	if (!tick_us.empty())
+	{
+		sort(tick_us.begin(), tick_us.end());
+		size_t n = tick_us.size();
+		printf("tick us: p50 %.1f  p99 %.1f  max %.1f\n",
+			tick_us[n / 2], tick_us[min(n - 1, n * 99 / 100)], tick_us[n - 1]);
+	}
+	return clean == options.runs ? 0 : 1;
+}
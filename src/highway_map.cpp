@@ -0,0 +1,336 @@
+#include "highway_map.h"
+#include <fstream>
+#include <sstream>
+#include <math.h>
+#include <algorithm>
+#include "spline.h"
+
+using namespace std;
+
+struct HighwayMap::Splines
+{
+	tk::spline x;
+	tk::spline y;
+	tk::spline dx;
+	tk::spline dy;
+};
+
+static double distance(double x1, double y1, double x2, double y2)
+{
+	return sqrt((x2-x1)*(x2-x1)+(y2-y1)*(y2-y1));
+}
+
+bool HighwayMap::load(const string &map_file)
+{
+	ifstream in_map_(map_file.c_str(), ifstream::in);
+
+	waypoints_x.clear();
+	waypoints_y.clear();
+	waypoints_s.clear();
+	waypoints_dx.clear();
+	waypoints_dy.clear();
+
+	string line;
+	while (getline(in_map_, line)) {
+		istringstream iss(line);
+		double x;
+		double y;
+		float s;
+		float d_x;
+		float d_y;
+		iss >> x;
+		iss >> y;
+		iss >> s;
+		iss >> d_x;
+		iss >> d_y;
+		waypoints_x.push_back(x);
+		waypoints_y.push_back(y);
+		waypoints_s.push_back(s);
+		waypoints_dx.push_back(d_x);
+		waypoints_dy.push_back(d_y);
+	}
+
+	if (waypoints_x.empty())
+	{
+		return false;
+	}
+
+	precompute();
+	return true;
+}
+
+void HighwayMap::precompute()
+{
+	int n = size();
+	seg_length.resize(n);
+	seg_dx.resize(n);
+	seg_dy.resize(n);
+	seg_cos.resize(n);
+	seg_sin.resize(n);
+	perp_cos.resize(n);
+	perp_sin.resize(n);
+	cumulative_s.resize(n + 1);
+
+	cumulative_s[0] = 0;
+	for (int i = 0; i < n; i++)
+	{
+		int next = (i + 1) % n;
+		double n_x = waypoints_x[next] - waypoints_x[i];
+		double n_y = waypoints_y[next] - waypoints_y[i];
+		double heading = atan2(n_y, n_x);
+
+		// the same values the conversions used to compute per call
+		seg_length[i] = sqrt(n_x*n_x + n_y*n_y);
+		seg_dx[i] = n_x;
+		seg_dy[i] = n_y;
+		seg_cos[i] = cos(heading);
+		seg_sin[i] = sin(heading);
+		perp_cos[i] = cos(heading - M_PI/2);
+		perp_sin[i] = sin(heading - M_PI/2);
+		cumulative_s[i + 1] = cumulative_s[i] + seg_length[i];
+	}
+
+	index.build(waypoints_x, waypoints_y);
+
+	fit_splines();
+}
+
+void HighwayMap::fit_splines()
+{
+	int n = size();
+
+	// pad both ends with waypoints from the other side of the loop so the
+	// splines stay smooth across s = 0
+	const int pad = min(3, n);
+	vector<double> s, x, y, dx, dy;
+	for (int k = n - pad; k < n + n + pad; k++)
+	{
+		int i = k % n;
+		s.push_back(waypoints_s[i] + (k / n - 1) * max_s);
+		x.push_back(waypoints_x[i]);
+		y.push_back(waypoints_y[i]);
+		dx.push_back(waypoints_dx[i]);
+		dy.push_back(waypoints_dy[i]);
+	}
+
+	Splines *fitted = new Splines;
+	fitted->x.set_points(s, x);
+	fitted->y.set_points(s, y);
+	fitted->dx.set_points(s, dx);
+	fitted->dy.set_points(s, dy);
+	splines.reset(fitted);
+}
+
+void HighwayMap::getXYSmooth(double s, double d, double &x, double &y) const
+{
+	s = wrap_s(s);
+
+	x = splines->x(s) + d*splines->dx(s);
+	y = splines->y(s) + d*splines->dy(s);
+}
+
+void HighwayMap::normal_smooth(double s, double &dx, double &dy) const
+{
+	s = wrap_s(s);
+
+	dx = splines->dx(s);
+	dy = splines->dy(s);
+}
+
+vector<double> HighwayMap::getXYSmooth(double s, double d) const
+{
+	double x;
+	double y;
+	getXYSmooth(s, d, x, y);
+	return {x,y};
+}
+
+// component of (x,y) - c(s) along the road, zero on the normal through c(s)
+double HighwayMap::tangential_offset(double x, double y, double s) const
+{
+	return -(x - splines->x(s))*splines->dy(s) + (y - splines->y(s))*splines->dx(s);
+}
+
+vector<double> HighwayMap::getFrenetSmooth(double x, double y, double theta, int &hint) const
+{
+	// start from the piecewise linear projection and refine s with Newton steps
+	// until (x,y) lies on the fitted normal through c(s), which makes this the
+	// exact inverse of getXYSmooth
+	vector<double> frenet = getFrenet(x, y, theta, hint);
+	double s = frenet[0];
+
+	const double h = 0.01;
+	for (int it = 0; it < 5; it++)
+	{
+		double f = tangential_offset(x, y, s);
+		double df = (tangential_offset(x, y, s + h) - tangential_offset(x, y, s - h)) / (2*h);
+		double ds = -f / df;
+		s += ds;
+		if (fabs(ds) < 1e-6)
+		{
+			break;
+		}
+	}
+
+	// the interpolated normal is not exactly unit length
+	double n_x = splines->dx(s);
+	double n_y = splines->dy(s);
+	double d = ((x - splines->x(s))*n_x + (y - splines->y(s))*n_y) / (n_x*n_x + n_y*n_y);
+
+	return {wrap_s(s),d};
+}
+
+int HighwayMap::ClosestWaypoint(double x, double y, int &hint) const
+{
+	return index.closest(x, y, hint);
+}
+
+int HighwayMap::NextWaypoint(double x, double y, double theta, int &hint) const
+{
+
+	int closestWaypoint = ClosestWaypoint(x,y,hint);
+
+	double map_x = waypoints_x[closestWaypoint];
+	double map_y = waypoints_y[closestWaypoint];
+
+	double heading = atan2( (map_y-y),(map_x-x) );
+
+	double angle = fabs(theta-heading);
+
+	if(angle > M_PI/4)
+	{
+		closestWaypoint++;
+	}
+
+	return closestWaypoint % size();
+
+}
+
+vector<double> HighwayMap::getFrenet(double x, double y, double theta) const
+{
+	int hint = -1;
+	return getFrenet(x, y, theta, hint);
+}
+
+vector<double> HighwayMap::getFrenet(double x, double y, double theta, int &hint) const
+{
+	int next_wp = NextWaypoint(x,y, theta, hint);
+
+	int prev_wp;
+	prev_wp = next_wp-1;
+	if(next_wp == 0)
+	{
+		prev_wp  = size()-1;
+	}
+
+	double n_x = seg_dx[prev_wp];
+	double n_y = seg_dy[prev_wp];
+	double x_x = x - waypoints_x[prev_wp];
+	double x_y = y - waypoints_y[prev_wp];
+
+	// find the projection of x onto n
+	double proj_norm = (x_x*n_x+x_y*n_y)/(n_x*n_x+n_y*n_y);
+	double proj_x = proj_norm*n_x;
+	double proj_y = proj_norm*n_y;
+
+	double frenet_d = distance(x_x,x_y,proj_x,proj_y);
+
+	//see if d value is positive or negative by comparing it to a center point
+
+	double center_x = 1000-waypoints_x[prev_wp];
+	double center_y = 2000-waypoints_y[prev_wp];
+	double centerToPos = distance(center_x,center_y,x_x,x_y);
+	double centerToRef = distance(center_x,center_y,proj_x,proj_y);
+
+	if(centerToPos <= centerToRef)
+	{
+		frenet_d *= -1;
+	}
+
+	// s value from the precomputed table
+	double frenet_s = cumulative_s[prev_wp];
+
+	frenet_s += distance(0,0,proj_x,proj_y);
+
+	return {frenet_s,frenet_d};
+
+}
+
+double HighwayMap::wrap_s(double s) const
+{
+	s = fmod(s, max_s);
+	if (s < 0)
+	{
+		s += max_s;
+	}
+	return s;
+}
+
+int HighwayMap::segment(double s, int &cursor) const
+{
+	int n = size();
+
+	// the cursor is still valid, or the point moved on by a few segments
+	if (cursor >= 0 && cursor < n && (cursor == 0 || s > waypoints_s[cursor]))
+	{
+		for (int k = 0; k < 4; k++)
+		{
+			if (cursor == n-1 || s <= waypoints_s[cursor+1])
+			{
+				return cursor;
+			}
+			cursor++;
+		}
+	}
+
+	// last waypoint with an s below the query, so a point exactly on a
+	// waypoint ends the segment before it as it always did
+	cursor = (int)(lower_bound(waypoints_s.begin(), waypoints_s.end(), s) - waypoints_s.begin()) - 1;
+	if (cursor < 0)
+	{
+		cursor = 0;
+	}
+	return cursor;
+}
+
+vector<double> HighwayMap::getXY(double s, double d) const
+{
+	int cursor = -1;
+	return getXY(s, d, cursor);
+}
+
+vector<double> HighwayMap::getXY(double s, double d, int &cursor) const
+{
+	double x;
+	double y;
+	getXY(s, d, cursor, x, y);
+	return {x,y};
+}
+
+void HighwayMap::getXY(double s, double d, int &cursor, double &x, double &y) const
+{
+	s = wrap_s(s);
+	int prev_wp = segment(s, cursor);
+
+	// the x,y,s along the segment
+	double seg_s = (s-waypoints_s[prev_wp]);
+
+	double seg_x = waypoints_x[prev_wp]+seg_s*seg_cos[prev_wp];
+	double seg_y = waypoints_y[prev_wp]+seg_s*seg_sin[prev_wp];
+
+	x = seg_x + d*perp_cos[prev_wp];
+	y = seg_y + d*perp_sin[prev_wp];
+}
+
+void HighwayMap::getXY(const vector<double> &s, const vector<double> &d, vector<double> &x, vector<double> &y) const
+{
+	x.resize(s.size());
+	y.resize(s.size());
+
+	// samples along a trajectory are monotone in s, so the cursor rarely has to search
+	int cursor = -1;
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		getXY(s[i], d[i], cursor, x[i], y[i]);
+	}
+}
@@ -0,0 +1,95 @@
+#ifndef HIGHWAY_MAP_H
+#define HIGHWAY_MAP_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "waypoint_index.h"
+
+// The highway waypoints together with per-segment tables computed once at load time.
+// Segment i runs from waypoint i to waypoint i+1 (the last one closes the loop).
+class HighwayMap
+{
+public:
+	// x,y,s and d normalized normal vectors as read from the csv
+	std::vector<double> waypoints_x;
+	std::vector<double> waypoints_y;
+	std::vector<double> waypoints_s;
+	std::vector<double> waypoints_dx;
+	std::vector<double> waypoints_dy;
+
+	// The max s value before wrapping around the track back to 0
+	double max_s;
+
+	// road layout on our side of the yellow line, lane 0 is the innermost
+	int num_lanes;
+	double lane_width;
+
+	explicit HighwayMap(int lanes = 3, double width = 4)
+		: max_s(6945.554), num_lanes(lanes), lane_width(width) {}
+
+	// d of the centre of a lane
+	double lane_center(int lane) const { return lane_width * (lane + 0.5); }
+
+	// read the waypoint csv and build the lookup tables, false if nothing was read;
+	// a second load replaces the waypoints of the first
+	bool load(const std::string &map_file);
+
+	int size() const { return (int)waypoints_x.size(); }
+
+	// Transform from Cartesian x,y coordinates to Frenet s,d coordinates.
+	// hint carries the closest waypoint of the previous call for the same vehicle.
+	std::vector<double> getFrenet(double x, double y, double theta, int &hint) const;
+	std::vector<double> getFrenet(double x, double y, double theta) const;
+
+	// Transform from Frenet s,d coordinates to Cartesian x,y.
+	// s is wrapped around the track; cursor keeps the segment of the last call.
+	std::vector<double> getXY(double s, double d) const;
+	std::vector<double> getXY(double s, double d, int &cursor) const;
+	void getXY(double s, double d, int &cursor, double &x, double &y) const;
+
+	// batch form for a whole trajectory of (s,d) samples, x and y are resized to match
+	void getXY(const std::vector<double> &s, const std::vector<double> &d,
+	           std::vector<double> &x, std::vector<double> &y) const;
+
+	// s in [0, max_s)
+	double wrap_s(double s) const;
+
+	// Smooth conversions from the x(s), y(s), dx(s), dy(s) splines fitted at load time.
+	// They avoid the kinks of the linear interpolation at every waypoint.
+	std::vector<double> getXYSmooth(double s, double d) const;
+	void getXYSmooth(double s, double d, double &x, double &y) const;
+	std::vector<double> getFrenetSmooth(double x, double y, double theta, int &hint) const;
+
+	// the fitted dx(s), dy(s) normal, pointing to the right of the road
+	// and close to unit length; the road runs along (-dy, dx)
+	void normal_smooth(double s, double &dx, double &dy) const;
+
+	int ClosestWaypoint(double x, double y, int &hint) const;
+	int NextWaypoint(double x, double y, double theta, int &hint) const;
+
+private:
+	WaypointIndex index;
+
+	std::vector<double> seg_length;   // length of segment i
+	std::vector<double> seg_dx;       // segment i from waypoint i to the next
+	std::vector<double> seg_dy;
+	std::vector<double> seg_cos;      // cos and sin of the heading of segment i
+	std::vector<double> seg_sin;
+	std::vector<double> perp_cos;     // cos and sin of that heading - pi/2
+	std::vector<double> perp_sin;
+	std::vector<double> cumulative_s; // polyline length from waypoint 0 to waypoint i
+
+	void precompute();
+	void fit_splines();
+	double tangential_offset(double x, double y, double s) const;
+
+	// spline coefficients, shared between copies of the map since they never change after load
+	struct Splines;
+	std::shared_ptr<const Splines> splines;
+
+	// index of the segment containing the wrapped s, searched from cursor
+	int segment(double s, int &cursor) const;
+};
+
+#endif /* HIGHWAY_MAP_H */
@@ -0,0 +1,71 @@
+#include "jmt.h"
+#include <algorithm>
+#include <math.h>
+#include "Eigen-3.3/Eigen/Core"
+#include "Eigen-3.3/Eigen/LU"
+
+using namespace std;
+
+typedef Eigen::Matrix<double, 6, 6> Matrix6;
+typedef Eigen::Matrix<double, 6, 1> Vector6;
+
+JmtSolver::JmtSolver(double T) : T(T)
+{
+	// rows: position, velocity and acceleration at 0, then the same at T
+	double T2 = T * T;
+	double T3 = T2 * T;
+	double T4 = T3 * T;
+	double T5 = T4 * T;
+	Matrix6 A;
+	A << 1, 0, 0, 0, 0, 0,
+	     0, 1, 0, 0, 0, 0,
+	     0, 0, 2, 0, 0, 0,
+	     1, T, T2, T3, T4, T5,
+	     0, 1, 2 * T, 3 * T2, 4 * T3, 5 * T4,
+	     0, 0, 2, 6 * T, 12 * T2, 20 * T3;
+	Eigen::Map<Matrix6> stored(inverse);
+	stored = A.fullPivLu().inverse();
+}
+
+Quintic JmtSolver::solve(const double start[3], const double end[3]) const
+{
+	Vector6 b;
+	b << start[0], start[1], start[2], end[0], end[1], end[2];
+
+	Quintic q;
+	Eigen::Map<Vector6> coefficients(q.a);
+	coefficients = Eigen::Map<const Matrix6>(inverse) * b;
+	return q;
+}
+
+JmtTable::JmtTable(const double *horizons, int n)
+{
+	solvers.reserve(n);
+	for (int k = 0; k < n; k++)
+	{
+		solvers.push_back(JmtSolver(horizons[k]));
+	}
+}
+
+void sample_xy(const HighwayMap &map, const FrenetTrajectory &traj, double dt, int n, double *x, double *y)
+{
+	for (int i = 0; i < n; i++)
+	{
+		double t = (i + 1) * dt;
+		map.getXYSmooth(traj.s.position(t), traj.d.position(t), x[i], y[i]);
+	}
+}
+
+double max_jerk(const Quintic &q, double T)
+{
+	double worst = max(fabs(q.jerk(0)), fabs(q.jerk(T)));
+	if (q.a[5] != 0)
+	{
+		double t = -24 * q.a[4] / (120 * q.a[5]);
+		if (t > 0 && t < T)
+		{
+			worst = max(worst, fabs(q.jerk(t)));
+		}
+	}
+	return worst;
+}
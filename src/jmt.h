@@ -0,0 +1,76 @@
+#ifndef JMT_H
+#define JMT_H
+
+#include <vector>
+#include "highway_map.h"
+
+// a0 + a1 t + a2 t^2 + a3 t^3 + a4 t^4 + a5 t^5
+struct Quintic
+{
+	double a[6];
+
+	double position(double t) const
+	{
+		return a[0] + t * (a[1] + t * (a[2] + t * (a[3] + t * (a[4] + t * a[5]))));
+	}
+	double velocity(double t) const
+	{
+		return a[1] + t * (2 * a[2] + t * (3 * a[3] + t * (4 * a[4] + t * 5 * a[5])));
+	}
+	double acceleration(double t) const
+	{
+		return 2 * a[2] + t * (6 * a[3] + t * (12 * a[4] + t * 20 * a[5]));
+	}
+	double jerk(double t) const
+	{
+		return 6 * a[3] + t * (24 * a[4] + t * 60 * a[5]);
+	}
+};
+
+// Jerk minimizing trajectory between two states {position, velocity,
+// acceleration} reached T seconds apart. The boundary condition matrix only
+// depends on T, so its inverse is computed once and every solve is a 6x6
+// matrix-vector product.
+class JmtSolver
+{
+public:
+	explicit JmtSolver(double T);
+
+	double duration() const { return T; }
+
+	Quintic solve(const double start[3], const double end[3]) const;
+
+private:
+	double T;
+	double inverse[36]; // column major, for an Eigen::Map
+};
+
+// one solver per horizon, for candidates that differ in duration
+class JmtTable
+{
+public:
+	JmtTable(const double *horizons, int n);
+
+	int size() const { return (int)solvers.size(); }
+	const JmtSolver &operator[](int k) const { return solvers[k]; }
+
+private:
+	std::vector<JmtSolver> solvers;
+};
+
+// quintic in s and d over the same duration
+struct FrenetTrajectory
+{
+	Quintic s;
+	Quintic d;
+	double T;
+};
+
+// n points dt apart, the first one dt after the start, through the smooth
+// frenet to xy conversion of the map
+void sample_xy(const HighwayMap &map, const FrenetTrajectory &traj, double dt, int n, double *x, double *y);
+
+// largest |jerk| over [0, T], exact since the jerk is a parabola in t
+double max_jerk(const Quintic &q, double T);
+
+#endif /* JMT_H */
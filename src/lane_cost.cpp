@@ -0,0 +1,160 @@
+#include "lane_cost.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <math.h>
+#include "velocity_profile.h"
+
+using namespace std;
+
+namespace
+{
+
+// m/s, the speed the planners drive at on a free road
+const double speed_limit = default_speed_limits().max_speed;
+
+// cars further ahead than this do not matter for the lane choice
+const double look_ahead = 250;
+
+// free space needed in the target lane, the car behind needs more the faster it closes in
+const double safe_gap_ahead = 40;
+const double safe_gap_behind = 25;
+const double closing_time = 2;
+
+// a car closer than this ahead sets our speed
+const double follow_gap = 60;
+
+// ticks a lane change needs to finish
+const double settle_ticks = 20;
+
+}
+
+void build_lane_features(const TrafficSnapshot &snapshot, const Prediction &traffic, int current_lane,
+                         double ego_speed, double ticks_since_change, LaneFeatures &out)
+{
+	out.lanes = min(snapshot.lanes(), (int)LaneFeatures::MAX_LANES);
+	out.current_lane = current_lane;
+	out.ego_speed = ego_speed;
+	out.ticks_since_change = ticks_since_change;
+
+	for (int lane = 0; lane < out.lanes; lane++)
+	{
+		const TrafficSnapshot::Entry *ahead = snapshot.nearest_ahead(lane);
+		const TrafficSnapshot::Entry *behind = snapshot.nearest_behind(lane);
+		out.gap_ahead[lane] = ahead ? ahead->gap : look_ahead;
+		out.speed_ahead[lane] = ahead ? traffic.track(ahead->car).s_dot : speed_limit;
+		out.gap_behind[lane] = behind ? -behind->gap : look_ahead;
+		out.speed_behind[lane] = behind ? traffic.track(behind->car).s_dot : 0;
+
+		double slowest = speed_limit;
+		TrafficSnapshot::Range cars = snapshot.between(lane, 0, look_ahead);
+		for (const TrafficSnapshot::Entry *car = cars.first; car != cars.second; car++)
+		{
+			slowest = min(slowest, traffic.track(car->car).s_dot);
+		}
+		out.lane_speed[lane] = slowest;
+		out.lane_offset[lane] = fabs((double)(lane - current_lane));
+	}
+}
+
+void GapAheadCost::operator()(const LaneFeatures &f, double *cost) const
+{
+	for (int lane = 0; lane < f.lanes; lane++)
+	{
+		cost[lane] = (f.lane_offset[lane] > 0 && f.gap_ahead[lane] < safe_gap_ahead) ? 1.0 : 0.0;
+	}
+}
+
+void GapBehindCost::operator()(const LaneFeatures &f, double *cost) const
+{
+	for (int lane = 0; lane < f.lanes; lane++)
+	{
+		double needed = safe_gap_behind + closing_time * max(0.0, f.speed_behind[lane] - f.ego_speed);
+		cost[lane] = (f.lane_offset[lane] > 0 && f.gap_behind[lane] < needed) ? 1.0 : 0.0;
+	}
+}
+
+void LaneSpeedCost::operator()(const LaneFeatures &f, double *cost) const
+{
+	for (int lane = 0; lane < f.lanes; lane++)
+	{
+		cost[lane] = max(0.0, speed_limit - f.lane_speed[lane]) / speed_limit;
+	}
+}
+
+void EfficiencyCost::operator()(const LaneFeatures &f, double *cost) const
+{
+	for (int lane = 0; lane < f.lanes; lane++)
+	{
+		double lost = f.gap_ahead[lane] < follow_gap ? max(0.0, speed_limit - f.speed_ahead[lane]) : 0.0;
+		cost[lane] = lost / speed_limit;
+	}
+}
+
+void LaneChangeCost::operator()(const LaneFeatures &f, double *cost) const
+{
+	for (int lane = 0; lane < f.lanes; lane++)
+	{
+		cost[lane] = min(1.0, f.lane_offset[lane]);
+	}
+}
+
+void JerkCost::operator()(const LaneFeatures &f, double *cost) const
+{
+	double unsettled = f.ticks_since_change <= settle_ticks ? 1.0 : 0.0;
+	for (int lane = 0; lane < f.lanes; lane++)
+	{
+		cost[lane] = f.lane_offset[lane] > 0 ? unsettled : 0.0;
+	}
+}
+
+bool read_cost_config(const string &path, vector<string> &names, vector<double> &values, string &error)
+{
+	ifstream in(path.c_str());
+	if (!in.is_open())
+	{
+		error = "cannot read " + path;
+		return false;
+	}
+
+	string line;
+	for (int number = 1; getline(in, line); number++)
+	{
+		line = line.substr(0, line.find('#'));
+		if (line.find_first_not_of(" \t\r") == string::npos)
+		{
+			continue;
+		}
+
+		size_t equals = line.find('=');
+		string name;
+		double value;
+		istringstream key(line.substr(0, equals));
+		istringstream number_text(equals == string::npos ? string() : line.substr(equals + 1));
+		string rest;
+		if (equals == string::npos || !(key >> name) || (key >> rest) || !(number_text >> value) ||
+			(number_text >> rest))
+		{
+			ostringstream message;
+			message << path << ":" << number << ": expected 'name = value'";
+			error = message.str();
+			return false;
+		}
+		names.push_back(name);
+		values.push_back(value);
+	}
+	return true;
+}
+
+LaneCostModel default_lane_costs()
+{
+	LaneCostModel model;
+	model.set_weight(GapAheadCost::name(), 1000);
+	model.set_weight(GapBehindCost::name(), 1000);
+	model.set_weight(JerkCost::name(), 1000);
+	model.set_weight(LaneSpeedCost::name(), 1);
+	model.set_weight(EfficiencyCost::name(), 2);
+	model.set_weight(LaneChangeCost::name(), 0.1);
+	return model;
+}
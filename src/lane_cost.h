@@ -0,0 +1,195 @@
+#ifndef LANE_COST_H
+#define LANE_COST_H
+
+#include <string>
+#include <vector>
+#include "prediction.h"
+#include "traffic.h"
+
+// What the cost terms know about every lane, one column per quantity so a
+// term scores all lanes in one loop.
+struct LaneFeatures
+{
+	static const int MAX_LANES = 8;
+
+	int lanes;
+	int current_lane;
+	double ego_speed;       // m/s, the reference speed
+	double ticks_since_change;
+
+	double gap_ahead[MAX_LANES];    // m to the closest car ahead, look_ahead when there is none
+	double speed_ahead[MAX_LANES];  // m/s of that car, the speed limit when there is none
+	double gap_behind[MAX_LANES];   // m to the closest car behind, look_ahead when there is none
+	double speed_behind[MAX_LANES]; // m/s of that car, 0 when there is none
+	double lane_speed[MAX_LANES];   // m/s of the slowest car within look_ahead, the speed limit when empty
+	double lane_offset[MAX_LANES];  // lanes to cross from the current one
+};
+
+// Fills the features from the cars of this tick, gaps as in the snapshot and
+// speeds along the road from the tracks it was built from.
+void build_lane_features(const TrafficSnapshot &snapshot, const Prediction &traffic, int current_lane,
+                         double ego_speed, double ticks_since_change, LaneFeatures &out);
+
+// Cost terms. Each scores every lane in [0, 1] and is scaled by its weight.
+
+// a car ahead in another lane closer than a safe merge distance
+struct GapAheadCost
+{
+	static const char *name() { return "gap_ahead"; }
+	void operator()(const LaneFeatures &f, double *cost) const;
+};
+
+// a car behind in another lane closer than it needs to react to us
+struct GapBehindCost
+{
+	static const char *name() { return "gap_behind"; }
+	void operator()(const LaneFeatures &f, double *cost) const;
+};
+
+// how far the slowest car ahead in the lane is below the speed limit
+struct LaneSpeedCost
+{
+	static const char *name() { return "lane_speed"; }
+	void operator()(const LaneFeatures &f, double *cost) const;
+};
+
+// how much speed we would give up behind the next car in the lane
+struct EfficiencyCost
+{
+	static const char *name() { return "efficiency"; }
+	void operator()(const LaneFeatures &f, double *cost) const;
+};
+
+// any lane change, so small differences do not make the car weave
+struct LaneChangeCost
+{
+	static const char *name() { return "lane_change"; }
+	void operator()(const LaneFeatures &f, double *cost) const;
+};
+
+// a new lane change before the last one has settled, the lateral jerk of
+// two changes back to back
+struct JerkCost
+{
+	static const char *name() { return "jerk"; }
+	void operator()(const LaneFeatures &f, double *cost) const;
+};
+
+// Weighted sum of the cost terms given as template arguments:
+//   cost[lane] = sum over terms of weight * term(features)[lane]
+template <class... Terms>
+class CostModel
+{
+public:
+	static const int TERMS = sizeof...(Terms);
+
+	CostModel()
+	{
+		for (int k = 0; k < TERMS; k++)
+		{
+			weights[k] = 1;
+		}
+	}
+
+	static const char *name(int k)
+	{
+		static const char *names[] = { Terms::name()... };
+		return names[k];
+	}
+
+	double weight(int k) const { return weights[k]; }
+
+	// false if no term has that name
+	bool set_weight(const std::string &term, double weight)
+	{
+		for (int k = 0; k < TERMS; k++)
+		{
+			if (term == name(k))
+			{
+				weights[k] = weight;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// "name = weight" lines, '#' starts a comment. False if the file cannot be
+	// read or names an unknown term, error then says which line.
+	bool load(const std::string &path, std::string &error);
+
+	// total cost of every lane, and each term's weighted share if per_term is given
+	void evaluate(const LaneFeatures &f, double *cost, double (*per_term)[LaneFeatures::MAX_LANES] = 0) const
+	{
+		for (int lane = 0; lane < f.lanes; lane++)
+		{
+			cost[lane] = 0;
+		}
+		Evaluate<0, Terms...>::run(f, weights, cost, per_term);
+	}
+
+private:
+	double weights[TERMS];
+
+	template <int K, class... Rest>
+	struct Evaluate
+	{
+		static void run(const LaneFeatures &, const double *, double *, double (*)[LaneFeatures::MAX_LANES]) {}
+	};
+
+	template <int K, class Term, class... Rest>
+	struct Evaluate<K, Term, Rest...>
+	{
+		static void run(const LaneFeatures &f, const double *weights, double *cost,
+		                double (*per_term)[LaneFeatures::MAX_LANES])
+		{
+			double term[LaneFeatures::MAX_LANES];
+			Term()(f, term);
+			for (int lane = 0; lane < f.lanes; lane++)
+			{
+				term[lane] *= weights[K];
+				cost[lane] += term[lane];
+			}
+			if (per_term)
+			{
+				for (int lane = 0; lane < f.lanes; lane++)
+				{
+					per_term[K][lane] = term[lane];
+				}
+			}
+			Evaluate<K + 1, Rest...>::run(f, weights, cost, per_term);
+		}
+	};
+};
+
+// reads "name = value" lines into the names and values, false with a message on a bad line
+bool read_cost_config(const std::string &path, std::vector<std::string> &names,
+                      std::vector<double> &values, std::string &error);
+
+template <class... Terms>
+bool CostModel<Terms...>::load(const std::string &path, std::string &error)
+{
+	std::vector<std::string> names;
+	std::vector<double> values;
+	if (!read_cost_config(path, names, values, error))
+	{
+		return false;
+	}
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (!set_weight(names[i], values[i]))
+		{
+			error = path + ": unknown cost term '" + names[i] + "'";
+			return false;
+		}
+	}
+	return true;
+}
+
+// The terms the planner decides lane changes with. The default weights make
+// the safety terms dominate everything else.
+typedef CostModel<GapAheadCost, GapBehindCost, LaneSpeedCost, EfficiencyCost, LaneChangeCost, JerkCost> LaneCostModel;
+
+// LaneCostModel with the default weights
+LaneCostModel default_lane_costs();
+
+#endif /* LANE_COST_H */
@@ -2,683 +2,187 @@
 #include <math.h>
 #include <uWS/uWS.h>
 #include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
-#include "Eigen-3.3/Eigen/Core"
-#include "Eigen-3.3/Eigen/QR"
-#include "json.hpp"
-#include "spline.h"
+#include "control_writer.h"
+#include "highway_map.h"
+#include "lane_cost.h"
+#include "planner.h"
+#include "session.h"
+#include "telemetry.h"
+#include "telemetry_log.h"
+#include "worker_pool.h"
 
 using namespace std;
 
-// for convenience
-using json = nlohmann::json;
-
-// For converting back and forth between radians and degrees.
-constexpr double pi() { return M_PI; }
-double deg2rad(double x) { return x * pi() / 180; }
-double rad2deg(double x) { return x * 180 / pi(); }
-
-// Checks if the SocketIO event has JSON data.
-// If there is data the JSON object in string format will be returned,
-// else the empty string "" will be returned.
-string hasData(string s) {
-  auto found_null = s.find("null");
-  auto b1 = s.find_first_of("[");
-  auto b2 = s.find_first_of("}");
-  if (found_null != string::npos) {
-    return "";
-  } else if (b1 != string::npos && b2 != string::npos) {
-    return s.substr(b1, b2 - b1 + 2);
-  }
-  return "";
-}
-
-double distance(double x1, double y1, double x2, double y2)
-{
-	return sqrt((x2-x1)*(x2-x1)+(y2-y1)*(y2-y1));
-}
-int ClosestWaypoint(double x, double y, vector<double> maps_x, vector<double> maps_y)
-{
-
-	double closestLen = 100000; //large number
-	int closestWaypoint = 0;
-
-	for(int i = 0; i < maps_x.size(); i++)
-	{
-		double map_x = maps_x[i];
-		double map_y = maps_y[i];
-		double dist = distance(x,y,map_x,map_y);
-		if(dist < closestLen)
-		{
-			closestLen = dist;
-			closestWaypoint = i;
-		}
-
-	}
-
-	return closestWaypoint;
-
-}
-
-int NextWaypoint(double x, double y, double theta, vector<double> maps_x, vector<double> maps_y)
-{
-
-	int closestWaypoint = ClosestWaypoint(x,y,maps_x,maps_y);
-
-	double map_x = maps_x[closestWaypoint];
-	double map_y = maps_y[closestWaypoint];
-
-	double heading = atan2( (map_y-y),(map_x-x) );
-
-	double angle = abs(theta-heading);
-
-	if(angle > pi()/4)
-	{
-		closestWaypoint++;
-	}
-
-	return closestWaypoint;
-
-}
-
-// Transform from Cartesian x,y coordinates to Frenet s,d coordinates
-vector<double> getFrenet(double x, double y, double theta, vector<double> maps_x, vector<double> maps_y)
-{
-	int next_wp = NextWaypoint(x,y, theta, maps_x,maps_y);
-
-	int prev_wp;
-	prev_wp = next_wp-1;
-	if(next_wp == 0)
-	{
-		prev_wp  = maps_x.size()-1;
-	}
-
-	double n_x = maps_x[next_wp]-maps_x[prev_wp];
-	double n_y = maps_y[next_wp]-maps_y[prev_wp];
-	double x_x = x - maps_x[prev_wp];
-	double x_y = y - maps_y[prev_wp];
-
-	// find the projection of x onto n
-	double proj_norm = (x_x*n_x+x_y*n_y)/(n_x*n_x+n_y*n_y);
-	double proj_x = proj_norm*n_x;
-	double proj_y = proj_norm*n_y;
-
-	double frenet_d = distance(x_x,x_y,proj_x,proj_y);
-
-	//see if d value is positive or negative by comparing it to a center point
-
-	double center_x = 1000-maps_x[prev_wp];
-	double center_y = 2000-maps_y[prev_wp];
-	double centerToPos = distance(center_x,center_y,x_x,x_y);
-	double centerToRef = distance(center_x,center_y,proj_x,proj_y);
-
-	if(centerToPos <= centerToRef)
-	{
-		frenet_d *= -1;
-	}
-
-	// calculate s value
-	double frenet_s = 0;
-	for(int i = 0; i < prev_wp; i++)
-	{
-		frenet_s += distance(maps_x[i],maps_y[i],maps_x[i+1],maps_y[i+1]);
-	}
-
-	frenet_s += distance(0,0,proj_x,proj_y);
-
-	return {frenet_s,frenet_d};
-
-}
-
-// Transform from Frenet s,d coordinates to Cartesian x,y
-vector<double> getXY(double s, double d, vector<double> maps_s, vector<double> maps_x, vector<double> maps_y)
-{
-	int prev_wp = -1;
-
-	while(s > maps_s[prev_wp+1] && (prev_wp < (int)(maps_s.size()-1) ))
-	{
-		prev_wp++;
-	}
-
-	int wp2 = (prev_wp+1)%maps_x.size();
-
-	double heading = atan2((maps_y[wp2]-maps_y[prev_wp]),(maps_x[wp2]-maps_x[prev_wp]));
-	// the x,y,s along the segment
-	double seg_s = (s-maps_s[prev_wp]);
+// Planning for every socket of one event loop. Each socket is only ever
+// served by its own loop, so its replies go out in the order of its messages.
+// All sessions of the loop share its WorkerPool for the candidate search.
+static void serve_sessions(uWS::Hub &h, SessionPool &sessions, TelemetryLogWriter &recorder, bool verbose,
+                           const LaneCostModel &costs, bool candidates, WorkerPool *pool) {
+  h.onMessage([&sessions, &recorder, verbose, &costs, candidates, pool](uWS::WebSocket<uWS::SERVER> ws, char *data,
+                     size_t length, uWS::OpCode opCode) {
+    // sockets transferred from the listener arrive without a session
+    Session *session = static_cast<Session *>(ws.getUserData());
+    if (!session) {
+      session = sessions.acquire();
+      session->planner.verbose = verbose;
+      session->planner.costs = costs;
+      session->planner.candidates = candidates;
+      session->planner.pool = pool;
+      ws.setUserData(session);
+    }
 
-	double seg_x = maps_x[prev_wp]+seg_s*cos(heading);
-	double seg_y = maps_y[prev_wp]+seg_s*sin(heading);
+    if (recorder.is_open()) {
+      recorder.write(LOG_INBOUND, session->connection, data, length);
+    }
 
-	double perp_heading = heading-pi()/2;
+    // "42" at the start of the message means there's a websocket message event.
+    // The 4 signifies a websocket message
+    // The 2 signifies a websocket event
+    TelemetryStatus status = parse_telemetry(data, length, session->telemetry);
 
-	double x = seg_x + d*cos(perp_heading);
-	double y = seg_y + d*sin(perp_heading);
+    if (status == TELEMETRY_OK) {
+      const Trajectory &path = session->planner.step(session->telemetry);
+      ControlWriter &control = session->control;
+      control.write(path.x, path.y, path.size);
 
-	return {x,y};
+      //this_thread::sleep_for(chrono::milliseconds(1000));
+      ws.send(control.data(), control.length(), uWS::OpCode::TEXT);
+      if (recorder.is_open()) {
+        recorder.write(LOG_OUTBOUND, session->connection, control.data(), control.length());
+      }
+    } else if (status == TELEMETRY_MANUAL) {
+      // Manual driving
+      std::string msg = "42[\"manual\",{}]";
+      ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
+      if (recorder.is_open()) {
+        recorder.write(LOG_OUTBOUND, session->connection, msg.data(), msg.length());
+      }
+    } else if (status == TELEMETRY_ERROR) {
+      // no reply, the simulator keeps driving the path it was last sent
+      std::cerr << "Malformed telemetry on connection " << session->connection << " (" << length << " bytes)"
+                << std::endl;
+    }
+  });
 
+  h.onDisconnection([&sessions](uWS::WebSocket<uWS::SERVER> ws, int code,
+                         char *message, size_t length) {
+    sessions.release(static_cast<Session *>(ws.getUserData()));
+    ws.setUserData(nullptr);
+    ws.close();
+    std::cout << "Disconnected" << std::endl;
+  });
 }
 
-int main() {
+int main(int argc, char *argv[]) {
   uWS::Hub h;
 
+  // --record <file> keeps every frame exchanged with the simulator for ./replay,
+  // frames of all connections go into the one log, tagged with the connection.
+  // --quiet drops the per tick planner output, for many simulators at once.
+  // --threads <n> plans on n event loops, the main one only accepts connections.
+  // --costs <file> sets the weights of the lane cost terms, see data/lane_costs.cfg.
+  // --candidates plans with the trajectory candidate search, --workers <n>
+  // evaluates the candidates of every event loop on n threads.
+  TelemetryLogWriter recorder;
+  bool verbose = true;
+  int threads = 0;
+  int workers = 1;
+  bool candidates = false;
+  LaneCostModel costs = default_lane_costs();
+  for (int i = 1; i < argc; i++) {
+    if (string(argv[i]) == "--quiet") {
+      verbose = false;
+    } else if (string(argv[i]) == "--costs" && i + 1 < argc) {
+      string error;
+      if (!costs.load(argv[++i], error)) {
+        std::cerr << error << std::endl;
+        return -1;
+      }
+    } else if (string(argv[i]) == "--candidates") {
+      candidates = true;
+    } else if (string(argv[i]) == "--workers" && i + 1 < argc) {
+      workers = max(1, atoi(argv[++i]));
+    } else if (string(argv[i]) == "--threads" && i + 1 < argc) {
+      threads = max(0, atoi(argv[++i]));
+    } else if (string(argv[i]) == "--record" && i + 1 < argc) {
+      if (!recorder.open(argv[++i])) {
+        std::cerr << "Failed to open " << argv[i] << " for recording" << std::endl;
+        return -1;
+      }
+    }
+  }
+
   // Load up map values for waypoint's x,y,s and d normalized normal vectors
-  vector<double> map_waypoints_x;
-  vector<double> map_waypoints_y;
-  vector<double> map_waypoints_s;
-  vector<double> map_waypoints_dx;
-  vector<double> map_waypoints_dy;
+  HighwayMap map;
 
   // Waypoint map to read from
   string map_file_ = "../data/highway_map.csv";
-  // The max s value before wrapping around the track back to 0
-  double max_s = 6945.554;
-
-  ifstream in_map_(map_file_.c_str(), ifstream::in);
 
-  string line;
-  while (getline(in_map_, line)) {
-  	istringstream iss(line);
-  	double x;
-  	double y;
-  	float s;
-  	float d_x;
-  	float d_y;
-  	iss >> x;
-  	iss >> y;
-  	iss >> s;
-  	iss >> d_x;
-  	iss >> d_y;
-  	map_waypoints_x.push_back(x);
-  	map_waypoints_y.push_back(y);
-  	map_waypoints_s.push_back(s);
-  	map_waypoints_dx.push_back(d_x);
-  	map_waypoints_dy.push_back(d_y);
+  if (!map.load(map_file_)) {
+    std::cerr << "Failed to read map " << map_file_ << std::endl;
+    return -1;
   }
-  // start in lane 1;
-  int lane = 1;
-  double t = 0;
-
-  // have a reference velocity to target
-  double ref_vel = 0.0; //mph
-
-  h.onMessage([&ref_vel, &t, &map_waypoints_x,&map_waypoints_y,&map_waypoints_s,&map_waypoints_dx,&map_waypoints_dy,&lane](uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length,
-                     uWS::OpCode opCode) {
-    // "42" at the start of the message means there's a websocket message event.
-    // The 4 signifies a websocket message
-    // The 2 signifies a websocket event
-    //auto sdata = string(data).substr(0, length);
-    //cout << sdata << endl;
-    if (length && length > 2 && data[0] == '4' && data[1] == '2') {
-
-      auto s = hasData(data);
-
-
-	 // double t = 0;
-	  if (s != "") {
-		  auto j = json::parse(s);
-
-		  string event = j[0].get<string>();
-
-		  if (event == "telemetry") {
-			  // j[1] is the data JSON object
-
-				// Main car's localization Data
-			  //double t = 0.0;
-			  double car_x = j[1]["x"];
-			  double car_y = j[1]["y"];
-			  double car_s = j[1]["s"];
-			  double car_d = j[1]["d"];
-			  double car_yaw = j[1]["yaw"];
-			  double car_speed = j[1]["speed"];
-
-			  // Previous path data given to the Planner
-			  auto previous_path_x = j[1]["previous_path_x"];
-			  auto previous_path_y = j[1]["previous_path_y"];
-			  // Previous path's end s and d values 
-			  double end_path_s = j[1]["end_path_s"];
-			  double end_path_d = j[1]["end_path_d"];
-
-			  // Sensor Fusion Data, a list of all other cars on the same side of the road.
-			  auto sensor_fusion = j[1]["sensor_fusion"];
-			  //json msgJson;
-
-			  //start
-			  int prev_size = 0;
-			  prev_size = previous_path_x.size();
-
-			  if (prev_size > 0)
-			  {
-				  car_s = end_path_s;
-			  }
-			  //cost variables
-			  bool too_close = false;
-			  double cost_laneto1 = 0;
-			  double cost_lane1to0 = 0;
-			  double cost_lane1to2 = 0;
-			  double cost_lane2to1 = 0;
-			  double cost_lane0to1 = 0;
-			  double lane0_vel = 50;
-			  double lane2_vel = 49;
-			  
-
-			  //find rev_v to use
-			  for (int i = 0; i < sensor_fusion.size(); i++)
-			  {
-				  
-				  float d = sensor_fusion[i][6];
-				  double vx = sensor_fusion[i][3];
-				  double vy = sensor_fusion[i][4];
-				  double check_speed = sqrt(vx*vx + vy*vy);
-				  double vel_too_close_car = 2.24 * check_speed;
-				  
-				  double check_car_s = sensor_fusion[i][5];
-				  double too_close_car_id = sensor_fusion[i][0];
-				 
-				  check_car_s += ((double)prev_size*.02*check_speed);// i
-				  ///checking the car in my lane///
-				  /// controlling speed; the closer the car the more deacceleration
-				  if (d < (2 + 4 * lane + 2) && d >(2 + 4 * lane - 2))
-				  {
-					  
-					  if ((check_car_s > car_s) && ((check_car_s - car_s) < 60))
-					  {
-
-
-						  if (vel_too_close_car < ref_vel)
-						  {
-							  ref_vel -= 0.35;
-							  
-						  }
-
-					  }
-
-					  if ((check_car_s > car_s) && ((check_car_s - car_s) < 40))
-					  {
-
-
-
-						  too_close = true;
-						  if (vel_too_close_car < ref_vel)
-						  {
-							  ref_vel -= 0.5;
-							  
-						  }
-					  }
-					  if ((check_car_s > car_s) && ((check_car_s - car_s) < 20))
-					  {
-						  if (vel_too_close_car < ref_vel)
-						  {
-							  ref_vel -= 0.7;
-							  
-						  }
-
-					  }
-					  if ((check_car_s > car_s) && ((check_car_s - car_s) < 15))
-					  {
-						  if (vel_too_close_car < ref_vel)
-						  {
-							  ref_vel -= 1.0;
-							  cost_lane1to0 += 1;
-							  cost_lane0to1 += 1;
-							  cost_lane1to2 += 1;
-							  cost_lane2to1 += 1;
-							  
-						  }
-
-					  }
-
-
-				  } 
-				  //////////////////////////////////////////////////////////////////
-				////evaluating sensor reading and calculating cost
-				  ///////////////////////////////////////////////////////////
-				//checking lane 0
-				 
-				  if (d < (2 + 4 * 0 + 2) && d >(2 + 4 * 0 - 2))
-
-				  {
-					  if (check_car_s > car_s - 20 && check_car_s < car_s + 20)
-					  {
-						  cost_lane1to0 += 1;
-						  cost_lane2to1 += 1;
-						  
-					  }
-					  if ((check_car_s > car_s) && ((check_car_s - car_s) < 250))// && (ref_vel - 5 > vel_too_close_car))
-					  {
-						  if (check_speed < lane0_vel)
-						  {
-							  lane0_vel = check_speed;
-						  }
-					  }
-
-
-					  if ((check_car_s > car_s) && ((check_car_s - car_s) < 40))// && (ref_vel - 5 > vel_too_close_car))
-					  {
-						  cost_lane1to0 += 1;
-						  
-					  }
-
-
-					  if ((check_car_s < car_s) && ((car_s - check_car_s) < 25))// && (ref_vel - 5 < vel_too_close_car))
-					  {
-						  
-						  cost_lane1to0 += 1;
-						  
-					  }
-
-
-
-				  }
-				  ////checking lane 1
-				  if (d < (2 + 4 * 1 + 2) && d >(2 + 4 * 1 - 2))
-
-				  {
-					  if (check_car_s > car_s - 20 && check_car_s < car_s + 20)
-					  {
-
-						  cost_lane0to1 += 1;
-						  cost_lane2to1 += 1;
-						 
-					  }
-
-					  if ((check_car_s > car_s) && ((check_car_s - car_s) < 40))// && (ref_vel - 5 > vel_too_close_car))
-					  {
-						  cost_lane0to1 += 1;
-						  cost_lane2to1 += 1;
-
-					  }
-
-
-					  if ((check_car_s < car_s) && ((car_s - check_car_s) < 25))// && (ref_vel + 5 < vel_too_close_car))
-					  {
-						  
-						  cost_lane0to1 += 1;
-						  cost_lane2to1 += 1;
-						  
-					  }
-
-
-
-				  }
-				  ////checking lane 2
-				  if (d < (2 + 4 * 2 + 2) && d >(2 + 4 * 2 - 2))
-
-				  {
-					  if (check_car_s > car_s - 20 && check_car_s < car_s + 20)
-					  {
-						  cost_lane1to2 += 1;
-						  cost_lane0to1 += 1;
-						  
-					  }
-					  if ((check_car_s > car_s) && ((check_car_s - car_s) < 250))// && (ref_vel - 5 > vel_too_close_car))
-					  {
-						  if (check_speed < lane2_vel)
-						  {
-							  lane2_vel = check_speed;
-						  }
-					  }
-					  if ((check_car_s > car_s) && ((check_car_s - car_s) < 40))// && (ref_vel - 5 > vel_too_close_car))
-					  {
-						  cost_lane1to2 += 1;
-						 
-					  }
-
-
-					  if ((check_car_s < car_s) && ((car_s - check_car_s) < 25))// && (ref_vel + 5 < vel_too_close_car))
-					  {
-						  
-						  cost_lane1to2 += 1;
-						  
-					  }
-
-
-
-				  }
-				 
-			  }
-			  ////////////////////////////////////////////////////////////////
-			  ////////Behaviour Planner///////////////////////////////
-			  ////////////////////////////////////////////////
-
-
-			  if (too_close)
-			  {
-				  ref_vel -= 0.7;
-			  }
-			  if (lane == 0)
-			  {
-				  if ((cost_lane0to1 < 1) && (t > 20))
-				  {
-					  lane = 1;
-					  cout << "lane change 0 to 1 XXXXXXXXXXXXXXXXXXXXXXX" << endl;
-					  t = 0;
-				  }
-			  }
-			  if (lane == 1)
-			  {
-				  if (too_close && (cost_lane1to0 < 1) && (cost_lane1to2 < 1) && (t > 20))
-				  {
-					  if (lane2_vel > lane0_vel)
-					  {
-						  lane = 2;
-						  cout << "lane change 1 to 2 XXXXXXXXXXXXXXXXXXXXXXX" << endl;
-						  t = 0;
-					  }
-					  if (lane2_vel < lane0_vel)
-					  {
-						  lane = 0;
-						  cout << "lane change 1 to 0 XXXXXXXXXXXXXXXXXXXXXXX" << endl;
-						  t = 0;
-					  }
-				  }
-				  if (too_close && (cost_lane1to0 < 1) && (t > 20))
-				  {
-					  lane = 0;
-					  cout << "lane change 1 to 0 XXXXXXXXXXXXXXXXXXXXXXX" << endl;
-					  t = 0;
-				  }
-				  if (too_close && (cost_lane1to2 < 1) && (t > 20))
-				  {
-					  lane = 2;
-					  cout << "lane change 1 to 2 XXXXXXXXXXXXXXXXXXXXXXX" << endl;
-					  t = 0;
-				  }
-
-
-			  }
-			  if (lane == 2)
-			  {
-				  if ((cost_lane2to1 < 1) && (t > 20))
-				  {
-					  lane = 1;
-					  cout << "lane change 2 to 1 XXXXXXXXXXXXXXXXXXXXXXX" << endl;
-					  t = 0;
-				  }
-			  }
-			t += 1;
-			if (ref_vel < 49.0)
-			{
-				ref_vel += .648;//.224;
-			}
-			
-			cout << cost_lane1to0 << " = cost_lane1to0 " << endl;
-			cout << cost_lane1to2 << " = cost_lane1to2 " << endl;
-			cout << cost_lane0to1 << " = cost_lane0to1 " << endl;
-			cout << cost_lane2to1 << " = cost_lane2to1 " << endl;
-			cout << t << " = t" << endl;
-			cout << 2.24 * lane0_vel << " = lane0_vel" << endl;
-			cout << 2.24 * lane2_vel << " = lane2_vel" << endl;
-			cout << ref_vel << " = ref_vel" << endl;
-
-			////////////////
-			//////////////////
-
-			vector<double> ptsx;
-			vector<double> ptsy;
-
-			//reference x, y ,yaw states
-			// either we will reference the starting point as where the car is or at the previous paths and point
-			 
-			double ref_x = car_x;
-			double ref_y = car_y;
-			double ref_yaw = deg2rad(car_yaw);
-
-			//if previous state is almost empty, use the car as starting reference
-			if (prev_size < 2)
-			{
-				//use two points that make the path tangent to the car
-				double prev_car_x = car_x - cos(car_yaw);
-				double prev_car_y = car_y - sin(car_yaw);
-
-				ptsx.push_back(prev_car_x);
-				ptsx.push_back(car_x);
-
-				ptsy.push_back(prev_car_y);
-				ptsy.push_back(car_y);
-			}
-			//use the previous path's and points as starting reference
-			else
-			{
-				//redefine reference state as previous path and point
-				ref_x = previous_path_x[prev_size - 1];
-				ref_y = previous_path_y[prev_size - 1];
-
-				double ref_x_prev = previous_path_x[prev_size-2];
-				double ref_y_prev = previous_path_y[prev_size-2];
-				ref_yaw = atan2(ref_y - ref_y_prev, ref_x - ref_x_prev);
-
-				//use two points that make the path tangent to the previous path's and point
-				ptsx.push_back(ref_x_prev);
-				ptsx.push_back(ref_x);
-
-				ptsy.push_back(ref_y_prev);
-				ptsy.push_back(ref_y);
-			}
-			
-			//in frenet add evenly 40m spaced points ahead of the starting reference
-			vector<double> next_wp0 = getXY(car_s + 40, (2 + 4 * lane), map_waypoints_s, map_waypoints_x, map_waypoints_y);
-			vector<double> next_wp1 = getXY(car_s + 80, (2 + 4 * lane), map_waypoints_s, map_waypoints_x, map_waypoints_y);
-			vector<double> next_wp2 = getXY(car_s + 120, (2 + 4 * lane), map_waypoints_s, map_waypoints_x, map_waypoints_y);
-			
-			ptsx.push_back(next_wp0[0]);
-			ptsx.push_back(next_wp1[0]);
-			ptsx.push_back(next_wp2[0]);
-			
-			ptsy.push_back(next_wp0[1]);
-			ptsy.push_back(next_wp1[1]);
-			ptsy.push_back(next_wp2[1]);
-			
-			for (int i = 0; i < ptsx.size(); i++)
-			{
-				//shift car referencde angle to 0 degrees
-				double shift_x = ptsx[i] - ref_x;
-				double shift_y = ptsy[i] - ref_y;
-
-				ptsx[i] = (shift_x * cos(0 - ref_yaw) - shift_y*sin(0 - ref_yaw));
-				ptsy[i] = (shift_x * sin(0 - ref_yaw) + shift_y*cos(0 - ref_yaw));
-			}
-
-			//create a spline
-
-			tk::spline s;
-			
 
-			// set (x,y) points to the spline
-			s.set_points(ptsx, ptsy);
-
-			//define the actual (x,y) points we will use for the planner
-
-
-
-          	//json msgJson;
-
-          	vector<double> next_x_vals;
-          	vector<double> next_y_vals;
-
-			//start with all of the previous path points from last time
-			for (int i = 0; i < previous_path_x.size(); i++)
-			{
-				next_x_vals.push_back(previous_path_x[i]);
-				next_y_vals.push_back(previous_path_y[i]);
-			}
-
-			//calculate how to break up spline points so that we travel at our desired reference velocity
-			double target_x = 40.0;
-			double target_y = s(target_x);
-			double target_dist = sqrt((target_x)*(target_x)+(target_y)*(target_y));
-
-			double x_add_on = 0;
-
-			// fill up the rest of our pat planner after filling it with previous points, here we will always output 80 points
-			for (int i = 1; i <= 80 - previous_path_x.size(); i++) {
-
-				double N = (target_dist / (.02*ref_vel / 2.24));
-				double x_point = x_add_on + (target_x) / N;
-				double y_point = s(x_point);
-
-				x_add_on = x_point;
-
-				double x_ref = x_point;
-				double y_ref = y_point;
-
-				//rotate back to normal after rotating it earlier
-				x_point = (x_ref *cos(ref_yaw) - y_ref*sin(ref_yaw));
-				y_point = (x_ref *sin(ref_yaw) + y_ref*cos(ref_yaw));
-
-				x_point += ref_x;
-				y_point += ref_y;
-
-				next_x_vals.push_back(x_point);
-				next_y_vals.push_back(y_point);
-
-
-
-			}
-
-
-
-
-
-
-
-          	// TODO: define a path made up of (x,y) points that the car will visit sequentially every .02 seconds
-			
-			/*double dist_inc = 0.3;
-			for (int i = 0; i < 50; i++)
-			{
-				double next_s = car_s + (i + 1)*dist_inc;
-				double next_d = 6;
-				vector<double> xy = getXY(next_s, next_d, map_waypoints_s, map_waypoints_x, map_waypoints_y);
-
-				next_x_vals.push_back(xy[0]);
-				next_y_vals.push_back(xy[1]);
-			}
-			*/
-
-
-			//end
-
-
-			json msgJson;
-			msgJson["next_x"] = next_x_vals;
-          	msgJson["next_y"] = next_y_vals;
-			
-
-          	auto msg = "42[\"control\","+ msgJson.dump()+"]";
-
-          	//this_thread::sleep_for(chrono::milliseconds(1000));
-          	ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-          
-        }
-      } else {
-        // Manual driving
-        std::string msg = "42[\"manual\",{}]";
-        ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
+  // one planner context per connected simulator, made below when the
+  // listener's loop serves the connections itself
+  std::unique_ptr<SessionPool> sessions;
+  std::unique_ptr<WorkerPool> pool;
+
+  // worker event loops, each with its own sessions, when --threads is given.
+  // They use the locals of main, so they are stopped and joined before it returns.
+  std::vector<uWS::Group<uWS::SERVER> *> groups(threads);
+  std::vector<uS::Async *> stops(threads);
+  std::vector<std::thread> loops;
+  std::mutex groups_lock;
+  std::condition_variable groups_ready;
+  int started = 0;
+  for (int i = 0; i < threads; i++) {
+    loops.push_back(std::thread([&, i]() {
+      uWS::Hub worker;
+      SessionPool worker_sessions(map);
+      WorkerPool worker_pool(workers);
+      serve_sessions(worker, worker_sessions, recorder, verbose, costs, candidates, &worker_pool);
+
+      // lets the listener move sockets onto this loop
+      worker.getDefaultGroup<uWS::SERVER>().addAsync();
+
+      // lets main end this loop: closing the group closes its sockets and
+      // its async, and run() returns once no handle is left
+      uS::Async *stop = new uS::Async(worker.getLoop());
+      stop->setData(&worker);
+      stop->start([](uS::Async *async) {
+        static_cast<uWS::Hub *>(async->getData())->getDefaultGroup<uWS::SERVER>().close();
+        async->close();
+      });
+      {
+        std::lock_guard<std::mutex> guard(groups_lock);
+        groups[i] = &worker.getDefaultGroup<uWS::SERVER>();
+        stops[i] = stop;
+        started++;
       }
+      groups_ready.notify_one();
+      worker.run();
+    }));
+  }
+  {
+    std::unique_lock<std::mutex> guard(groups_lock);
+    groups_ready.wait(guard, [&]() { return started == threads; });
+  }
+  auto stop_loops = [&]() {
+    for (uS::Async *stop : stops) {
+      stop->send();
     }
-  });
+    for (std::thread &loop : loops) {
+      loop.join();
+    }
+  };
 
   // We don't need this since we're not using HTTP but if it's removed the
   // program
@@ -694,102 +198,40 @@ int main() {
     }
   });
 
-  h.onConnection([&h](uWS::WebSocket<uWS::SERVER> ws, uWS::HttpRequest req) {
-    std::cout << "Connected!!!" << std::endl;
-  });
-
-  h.onDisconnection([&h](uWS::WebSocket<uWS::SERVER> ws, int code,
-                         char *message, size_t length) {
-    ws.close();
-    std::cout << "Disconnected" << std::endl;
-  });
+  int next_group = 0;
+  if (threads > 0) {
+    // the listener only accepts, connections are dealt out round robin
+    h.onConnection([&groups, &next_group](uWS::WebSocket<uWS::SERVER> ws, uWS::HttpRequest req) {
+      int i = next_group;
+      next_group = (next_group + 1) % (int)groups.size();
+      std::cout << "Connected!!! (event loop " << i << ")" << std::endl;
+      ws.transfer(groups[i]);
+    });
+  } else {
+    sessions.reset(new SessionPool(map));
+    pool.reset(new WorkerPool(workers));
+    serve_sessions(h, *sessions, recorder, verbose, costs, candidates, pool.get());
+
+    h.onConnection([&h, &sessions, verbose, &costs, candidates, &pool](uWS::WebSocket<uWS::SERVER> ws,
+                                                                          uWS::HttpRequest req) {
+      Session *session = sessions->acquire();
+      session->planner.verbose = verbose;
+      session->planner.costs = costs;
+      session->planner.candidates = candidates;
+      session->planner.pool = pool.get();
+      ws.setUserData(session);
+      std::cout << "Connected!!! (" << sessions->in_use() << " sessions)" << std::endl;
+    });
+  }
 
   int port = 4567;
   if (h.listen(port)) {
     std::cout << "Listening to port " << port << std::endl;
   } else {
     std::cerr << "Failed to listen to port" << std::endl;
+    stop_loops();
     return -1;
   }
   h.run();
+  stop_loops();
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
@@ -0,0 +1,249 @@
+#include "path_generator.h"
+#include <algorithm>
+#include <math.h>
+#include "fixed_spline.h"
+
+using namespace std;
+
+namespace
+{
+
+// local x between the nodes of the arc length table, and the most nodes,
+// well past the farthest point a path is sampled at
+const double arc_step = 5.0;
+const int max_arc_nodes = 65;
+
+// m of extra anchor spacing per m the path still has to move sideways, up
+// to a lane width. The lateral jerk of a lane change falls with the square
+// of the spacing.
+const double lane_change_stretch = 17.5;
+
+// The start's d is the simulator's end_path_d, which is off the fitted
+// map's frame by 0.2 m on average and up to 2.4 m. The stretch grows with
+// the square of offsets much smaller than this and linearly beyond, so that
+// noise does not spread the anchors while staying in a lane.
+const double lane_change_deadband = 1.0;
+
+// closer points give no direction to fit the spline along
+bool same_point(double x0, double y0, double x1, double y1)
+{
+	return fabs(x1 - x0) < 1e-3 && fabs(y1 - y0) < 1e-3;
+}
+
+}
+
+struct PathSpline::Curve
+{
+	tk::fixed_spline<5> s;
+
+	// length of the spline from local x 0 to node k at local x k * arc_step,
+	// and its rate of change sqrt(1 + y'^2) there
+	int nodes;
+	double length[max_arc_nodes];
+	double rate[max_arc_nodes];
+
+	void extend(double distance);
+};
+
+// Adds nodes until the table reaches distance. Every step is integrated with
+// Simpson's rule, and as every step is at least arc_step long one batch of
+// spline evaluations is enough.
+void PathSpline::Curve::extend(double distance)
+{
+	if (nodes == 0)
+	{
+		double x = 0, y, dy;
+		s.eval_sorted(&x, 1, &y, &dy);
+		length[0] = 0;
+		rate[0] = sqrt(1 + dy * dy);
+		nodes = 1;
+	}
+	while (length[nodes - 1] < distance && nodes < max_arc_nodes)
+	{
+		int add = (int)ceil((distance - length[nodes - 1]) / arc_step);
+		add = max(1, min(max_arc_nodes - nodes, add));
+
+		// the middle and the end of every new step
+		double x[2 * max_arc_nodes];
+		double y[2 * max_arc_nodes];
+		double dy[2 * max_arc_nodes];
+		double from = (nodes - 1) * arc_step;
+		for (int i = 0; i < 2 * add; i++)
+		{
+			x[i] = from + (i + 1) * (arc_step / 2);
+		}
+		s.eval_sorted(x, 2 * add, y, dy);
+		for (int i = 0; i < add; i++)
+		{
+			double middle = sqrt(1 + dy[2 * i] * dy[2 * i]);
+			double end = sqrt(1 + dy[2 * i + 1] * dy[2 * i + 1]);
+			length[nodes] = length[nodes - 1] + arc_step / 6 * (rate[nodes - 1] + 4 * middle + end);
+			rate[nodes] = end;
+			nodes++;
+		}
+	}
+}
+
+PathStart path_start(const Telemetry &j)
+{
+	PathStart start;
+	int prev_size = j.previous_path_size;
+	start.reused = prev_size;
+	start.s = prev_size > 0 ? j.end_path_s : j.s;
+	start.d = prev_size > 0 ? j.end_path_d : j.d;
+
+	//if previous state is almost empty, use the car as starting reference
+	if (prev_size < 2)
+	{
+		start.x = j.x;
+		start.y = j.y;
+		start.yaw = j.yaw * M_PI / 180;
+
+		//use two points that make the path tangent to the car
+		start.prev_x = j.x - cos(start.yaw);
+		start.prev_y = j.y - sin(start.yaw);
+	}
+	//use the previous path's and points as starting reference
+	else
+	{
+		start.x = j.previous_path_x[prev_size - 1];
+		start.y = j.previous_path_y[prev_size - 1];
+
+		// a path that brakes to a stop ends in the same point several times,
+		// the tangent comes from the last point before them
+		int k = prev_size - 2;
+		while (k > 0 && same_point(j.previous_path_x[k], j.previous_path_y[k], start.x, start.y))
+		{
+			k--;
+		}
+		start.prev_x = j.previous_path_x[k];
+		start.prev_y = j.previous_path_y[k];
+		if (same_point(start.prev_x, start.prev_y, start.x, start.y))
+		{
+			start.yaw = j.yaw * M_PI / 180;
+			start.prev_x = start.x - cos(start.yaw);
+			start.prev_y = start.y - sin(start.yaw);
+		}
+		else
+		{
+			start.yaw = atan2(start.y - start.prev_y, start.x - start.prev_x);
+		}
+	}
+	return start;
+}
+
+PathSpline::PathSpline() : curve(new Curve)
+{
+	curve->nodes = 0;
+}
+
+PathSpline::~PathSpline()
+{
+}
+
+void PathSpline::fit(const HighwayMap &map, const PathStart &start, double d, double spacing)
+{
+	// offsets well inside the deadband barely stretch, a full lane width
+	// still gets the full stretch
+	double sideways = min(fabs(d - start.d), map.lane_width);
+	double stretched = sideways * sideways / (sideways + lane_change_deadband)
+		* (map.lane_width + lane_change_deadband) / map.lane_width;
+	spacing += lane_change_stretch * stretched;
+
+	const double ahead[3] = { spacing, 2 * spacing, 3 * spacing };
+	const double offset[3] = { d, d, d };
+	fit(map, start, ahead, offset);
+}
+
+void PathSpline::fit(const HighwayMap &map, const PathStart &start, const double *ahead, const double *d)
+{
+	ref_x = start.x;
+	ref_y = start.y;
+	cos_yaw = cos(start.yaw);
+	sin_yaw = sin(start.yaw);
+
+	double ptsx[5] = { start.prev_x, start.x };
+	double ptsy[5] = { start.prev_y, start.y };
+
+	//in frenet add the points ahead of the starting reference
+	for (int k = 0; k < 3; k++)
+	{
+		map.getXYSmooth(start.s + ahead[k], d[k], ptsx[k + 2], ptsy[k + 2]);
+	}
+
+	double xs[5];
+	double ys[5];
+	for (int i = 0; i < 5; i++)
+	{
+		//shift car reference angle to 0 degrees
+		double shift_x = ptsx[i] - ref_x;
+		double shift_y = ptsy[i] - ref_y;
+
+		xs[i] = (shift_x * cos(0 - start.yaw) - shift_y*sin(0 - start.yaw));
+		ys[i] = (shift_x * sin(0 - start.yaw) + shift_y*cos(0 - start.yaw));
+	}
+	curve->s.set_points(xs, ys);
+	curve->nodes = 0;
+}
+
+void PathSpline::point(double local_x, double &x, double &y) const
+{
+	double local_y = curve->s(local_x);
+
+	//rotate back to normal after rotating it earlier
+	x = (local_x * cos_yaw - local_y * sin_yaw) + ref_x;
+	y = (local_x * sin_yaw + local_y * cos_yaw) + ref_y;
+}
+
+void PathSpline::points(const double *local_x, int n, double *x, double *y) const
+{
+	// local y first, into y
+	curve->s.eval_sorted(local_x, n, y);
+	for (int i = 0; i < n; i++)
+	{
+		double local_y = y[i];
+		x[i] = (local_x[i] * cos_yaw - local_y * sin_yaw) + ref_x;
+		y[i] = (local_x[i] * sin_yaw + local_y * cos_yaw) + ref_y;
+	}
+}
+
+void PathSpline::local_x_at(const double *distance, int n, double *local_x)
+{
+	if (n == 0)
+	{
+		return;
+	}
+	curve->extend(distance[n - 1]);
+
+	const Curve &c = *curve;
+	int last = c.nodes - 1;
+	int k = 0;
+	for (int i = 0; i < n; i++)
+	{
+		double d = distance[i];
+		if (d >= c.length[last])
+		{
+			// past the table, straight on
+			local_x[i] = last * arc_step + (d - c.length[last]) / c.rate[last];
+			continue;
+		}
+		while (k > 0 && d < c.length[k])
+		{
+			k--;
+		}
+		while (c.length[k + 1] <= d)
+		{
+			k++;
+		}
+
+		// x over the length between two nodes as the cubic with the slopes
+		// 1 / rate at both of them
+		double h = c.length[k + 1] - c.length[k];
+		double t = (d - c.length[k]) / h;
+		double t2 = t * t;
+		double t3 = t2 * t;
+		double x0 = k * arc_step;
+		local_x[i] = (2 * t3 - 3 * t2 + 1) * x0 + (t3 - 2 * t2 + t) * h / c.rate[k]
+			+ (3 * t2 - 2 * t3) * (x0 + arc_step) + (t3 - t2) * h / c.rate[k + 1];
+	}
+}
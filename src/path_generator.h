@@ -0,0 +1,64 @@
+#ifndef PATH_GENERATOR_H
+#define PATH_GENERATOR_H
+
+#include <memory>
+#include "highway_map.h"
+#include "telemetry.h"
+
+// Where the new points of a tick continue from: the end of the previous path,
+// or the car itself when less than two points are left.
+struct PathStart
+{
+	double x;      // reference point
+	double y;
+	double yaw;    // heading at the reference point, radians
+	double prev_x; // point behind the reference that fixes the tangent
+	double prev_y;
+	double s;      // s the anchors ahead are measured from
+	double d;      // lane offset there
+	int reused;    // points kept from the previous path
+};
+
+PathStart path_start(const Telemetry &j);
+
+// Spline from the start through three anchors spacing m apart on lane offset
+// d, fitted in the frame of the reference point where x points along yaw.
+// A start off d spreads the anchors further, so a lane change at full speed
+// stays within the jerk limit.
+class PathSpline
+{
+public:
+	PathSpline();
+	~PathSpline();
+
+	void fit(const HighwayMap &map, const PathStart &start, double d, double spacing);
+
+	// The same through three anchors ahead[k] m past start.s on lane offset
+	// d[k], for a lateral motion shaped by the caller.
+	void fit(const HighwayMap &map, const PathStart &start, const double *ahead, const double *d);
+
+	// world position of the spline point local_x ahead of the reference point
+	void point(double local_x, double &x, double &y) const;
+
+	// point() for n local_x at once, fastest when they increase
+	void points(const double *local_x, int n, double *x, double *y) const;
+
+	// Local x of the points the increasing distances along the spline from
+	// the reference point, so new points can be spaced by the distance driven
+	// per step. Looked up in a table of the length up to every few metres of
+	// local x, which grows to the longest distance asked for since fit().
+	void local_x_at(const double *distance, int n, double *local_x);
+
+private:
+	struct Curve;
+	std::unique_ptr<Curve> curve;
+	double ref_x;
+	double ref_y;
+	double cos_yaw;
+	double sin_yaw;
+
+	PathSpline(const PathSpline &);
+	PathSpline &operator=(const PathSpline &);
+};
+
+#endif /* PATH_GENERATOR_H */
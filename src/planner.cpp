@@ -0,0 +1,241 @@
+#include "planner.h"
+#include <iostream>
+#include <math.h>
+#include "candidate_search.h"
+
+using namespace std;
+
+Planner::Planner(const HighwayMap &map)
+	: verbose(false), candidates(false), pool(NULL), costs(default_lane_costs()), map(map), lane(1), t(0),
+	  ref_vel(0.0), lanes(new TrafficSnapshot), search(new CandidateSearch(map)),
+	  prediction(map)
+{
+}
+
+Planner::~Planner()
+{
+}
+
+void Planner::reset()
+{
+	lane = 1;
+	t = 0;
+	ref_vel = 0.0;
+	prediction.reset();
+	committed.clear();
+}
+
+const Trajectory &Planner::step(const Telemetry &j)
+{
+	if (candidates)
+	{
+		return step_candidates(j);
+	}
+
+	// Main car's localization Data
+	double car_s = j.s;
+	double car_d = j.d;
+
+	// Previous path's end s and d values
+	double end_path_s = j.end_path_s;
+	double end_path_d = j.end_path_d;
+
+	//start
+	int prev_size = 0;
+	prev_size = j.previous_path_size;
+
+	// tracks move on by the time of the points driven since the last tick
+	int driven = max(0, committed.size() - prev_size);
+	committed.sync(j);
+	prediction.update(j.sensor_fusion, driven * .02);
+
+	if (prev_size > 0)
+	{
+		car_s = end_path_s;
+	}
+
+	// every car where it is at the end of the previous path, by lane
+	lanes->build(prediction, (double)prev_size*.02, car_s, map.num_lanes, map.max_s);
+
+	////////////////////////////////////////////////////////////////
+	////////Behaviour Planner///////////////////////////////
+	////////////////////////////////////////////////
+	// every lane scored by the cost terms, move to the cheapest neighbour
+	build_lane_features(*lanes, prediction, lane, ref_vel / 2.24, t, features);
+	double cost[LaneFeatures::MAX_LANES];
+	double per_term[LaneCostModel::TERMS][LaneFeatures::MAX_LANES];
+	costs.evaluate(features, cost, verbose ? per_term : 0);
+
+	int from = lane;
+	int best = lane;
+	for (int k = max(lane - 1, 0); k <= min(lane + 1, features.lanes - 1); k++)
+	{
+		if (cost[k] < cost[best])
+		{
+			best = k;
+		}
+	}
+	if (best != lane)
+	{
+		if (verbose)
+		{
+			cout << "lane change " << lane << " to " << best << " XXXXXXXXXXXXXXXXXXXXXXX" << endl;
+		}
+		lane = best;
+		t = 0;
+	}
+
+	t += 1;
+
+	// speed of every new point, as fast as the limits allow behind the
+	// closest car ahead in the lane and, until a lane change is done, in the
+	// lanes the car is still in
+	int here = (int)floor(car_d / map.lane_width);
+	int there = (int)floor(end_path_d / map.lane_width);
+	int lo = max(0, min(min(here, there), min(from, lane)));
+	int hi = min(map.num_lanes - 1, max(max(here, there), max(from, lane)));
+	LeadVehicle lead;
+	const LeadVehicle *follow = NULL;
+	for (int k = lo; k <= hi; k++)
+	{
+		const TrafficSnapshot::Entry *car = lanes->nearest_ahead(k);
+		if (car && (!follow || car->gap < lead.gap))
+		{
+			lead.gap = car->gap;
+			lead.speed = max(0.0, prediction.track(car->car).s_dot);
+			follow = &lead;
+		}
+	}
+	int count = max(0, 80 - prev_size);
+	double speeds[80];
+	double v0, a0;
+	end_state(v0, a0);
+	profile.plan(v0, a0, profile.limits().max_speed, follow, count, speeds);
+	if (count > 0)
+	{
+		ref_vel = speeds[count - 1] * 2.24;
+	}
+
+	if (verbose)
+	{
+		for (int k = 0; k < LaneCostModel::TERMS; k++)
+		{
+			cout << LaneCostModel::name(k) << ":";
+			for (int i = 0; i < features.lanes; i++)
+			{
+				cout << " " << per_term[k][i];
+			}
+			cout << endl;
+		}
+		cout << "total:";
+		for (int i = 0; i < features.lanes; i++)
+		{
+			cout << " " << cost[i];
+		}
+		cout << endl;
+		cout << t << " = t" << endl;
+		cout << ref_vel << " = ref_vel" << endl;
+	}
+
+	////////////////
+	//////////////////
+
+	//spline from the end of the previous path through points 40m apart in the lane
+	PathStart start = path_start(j);
+	PathSpline &s = spline;
+	s.fit(map, start, map.lane_center(lane), 40.0);
+
+	//the points of the previous path are still in committed, only add to its end
+
+	//space the new points by the distance travelled at their speed in 0.02 s
+	double travelled = 0;
+	double distance[80];
+	for (int i = 0; i < count; i++) {
+		travelled += .02*speeds[i];
+		distance[i] = travelled;
+	}
+	double local_x[80];
+	s.local_x_at(distance, count, local_x);
+
+	// all new points through the spline in one pass
+	double x_points[80];
+	double y_points[80];
+	s.points(local_x, count, x_points, y_points);
+	for (int i = 0; i < count; i++)
+	{
+		committed.extend(x_points[i], y_points[i], speeds[i]);
+	}
+
+	trajectory.x = committed.x();
+	trajectory.y = committed.y();
+	trajectory.size = committed.size();
+
+	return trajectory;
+}
+
+void Planner::end_state(double &v, double &a) const
+{
+	int last = committed.size() - 1;
+	if (last >= 0 && !isnan(committed.v(last)))
+	{
+		v = committed.v(last);
+		a = committed.a(last);
+	}
+	else
+	{
+		// taken over from the simulator, or standing
+		v = ref_vel / 2.24;
+		a = 0;
+	}
+}
+
+// The lane costs only rank the lanes here. Lane and speed come from the
+// cheapest candidate that keeps clear of the predicted traffic.
+const Trajectory &Planner::step_candidates(const Telemetry &j)
+{
+	PathStart start = path_start(j);
+
+	// tracks move on by the time of the points driven since the last tick
+	int driven = max(0, committed.size() - j.previous_path_size);
+	committed.sync(j);
+	prediction.update(j.sensor_fusion, driven * .02);
+
+	lanes->build(prediction, start.reused * .02, start.s, map.num_lanes, map.max_s);
+	build_lane_features(*lanes, prediction, lane, ref_vel / 2.24, t, features);
+	double cost[LaneFeatures::MAX_LANES];
+	costs.evaluate(features, cost, 0);
+
+	prediction.predict(.02, CandidateSearch::checks(start.reused), j.s,
+	                   CandidateSearch::reach());
+
+	double v0, a0;
+	end_state(v0, a0);
+	const Candidate &best = search->search(j, start, prediction, lane, v0 * 2.24, a0, cost, pool);
+	if (best.lane != lane)
+	{
+		if (verbose)
+		{
+			cout << "lane change " << lane << " to " << best.lane << " XXXXXXXXXXXXXXXXXXXXXXX" << endl;
+		}
+		lane = best.lane;
+		t = 0;
+	}
+	t += 1;
+	ref_vel = best.final_speed;
+
+	if (verbose)
+	{
+		cout << "candidate: lane " << best.lane << " speed " << best.speed << " horizon " << best.horizon
+			<< (best.feasible ? "" : " (none feasible)") << " cost " << best.cost << endl;
+		cout << ref_vel << " = ref_vel" << endl;
+	}
+
+	for (size_t i = 0; i < best.x.size(); i++)
+	{
+		committed.extend(best.x[i], best.y[i], best.v[i]);
+	}
+	trajectory.x = committed.x();
+	trajectory.y = committed.y();
+	trajectory.size = committed.size();
+	return trajectory;
+}
@@ -0,0 +1,86 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <memory>
+#include <vector>
+#include "highway_map.h"
+#include "lane_cost.h"
+#include "path_generator.h"
+#include "prediction.h"
+#include "telemetry.h"
+#include "traffic.h"
+#include "trajectory_buffer.h"
+#include "velocity_profile.h"
+
+class CandidateSearch;
+class WorkerPool;
+
+// Points the car will visit sequentially every .02 seconds
+struct Trajectory
+{
+	const double *x;
+	const double *y;
+	int size;
+};
+
+// Behaviour and trajectory planning for one car, independent of the simulator
+// connection. step() is called once per telemetry message.
+class Planner
+{
+public:
+	explicit Planner(const HighwayMap &map);
+	~Planner();
+
+	// plan from the latest telemetry. The returned trajectory is owned by the
+	// planner and stays valid until the next call. It starts with the points
+	// of the previous path, only the driven ones are replaced at its end.
+	const Trajectory &step(const Telemetry &j);
+
+	// back to the state of a new drive: middle lane, standing still
+	void reset();
+
+	// print lane changes and cost values to stdout every tick
+	bool verbose;
+
+	// pick lane and speed from many trajectory candidates checked against the
+	// predicted traffic instead of the speed controller and lane costs alone
+	bool candidates;
+
+	// threads for the candidate evaluation, NULL evaluates on the caller's
+	// thread. Not owned, planners may share one.
+	WorkerPool *pool;
+
+	// weights of the lane choice, default_lane_costs() unless replaced
+	LaneCostModel costs;
+
+	int current_lane() const { return lane; }
+	double reference_velocity() const { return ref_vel; }
+
+private:
+	const HighwayMap &map;
+
+	// start in lane 1;
+	int lane;
+	// ticks since the last lane change
+	double t;
+	// have a reference velocity to target
+	double ref_vel; //mph
+
+	// per tick scratch space, allocated once
+	std::unique_ptr<TrafficSnapshot> lanes;
+	LaneFeatures features;
+	TrajectoryBuffer committed; // sent and not driven yet
+	Trajectory trajectory;      // view of committed
+	PathSpline spline;
+	VelocityProfile profile;
+	std::unique_ptr<CandidateSearch> search;
+	Prediction prediction;
+
+	const Trajectory &step_candidates(const Telemetry &j);
+
+	// speed and acceleration at the end of the committed points, the new
+	// points continue from there
+	void end_state(double &v, double &a) const;
+};
+
+#endif /* PLANNER_H */
@@ -0,0 +1,1018 @@
+// Micro benchmarks for the map, spline and message code, and a macro
+// benchmark of the full per-tick cycle (parse, plan, serialize).
+//
+// Run from the build directory so ../data/highway_map.csv is found:
+//   ./planner_bench --benchmark_counters_tabular=true
+//
+// With --check it instead compares the fast code with the reference it
+// replaces and exits non zero on any difference (ctest runs it).
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <math.h>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "collision.h"
+#include "control_writer.h"
+#include "fixed_spline.h"
+#include "highway_map.h"
+#include "jmt.h"
+#include "planner.h"
+#include "sensor_fusion.h"
+#include "simulator.h"
+#include "small_spline.h"
+#include "spline.h"
+#include "telemetry.h"
+#include "velocity_profile.h"
+
+using namespace std;
+
+// Every heap allocation in the process goes through here so each benchmark
+// can report allocations per operation. The whole set of replaceable
+// operators is replaced, so every new is paired with a delete that frees.
+static atomic<long> allocations(0);
+
+static void *counted_alloc(size_t size) noexcept
+{
+	allocations.fetch_add(1, memory_order_relaxed);
+	return malloc(size ? size : 1);
+}
+
+// kept out of line: inlined into a caller, GCC sees free() on a pointer
+// from operator new and warns about a mismatched pair
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+static void counted_free(void *p) noexcept
+{
+	free(p);
+}
+
+void *operator new(size_t size)
+{
+	void *p = counted_alloc(size);
+	if (!p)
+	{
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void *operator new[](size_t size)
+{
+	void *p = counted_alloc(size);
+	if (!p)
+	{
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+	return counted_alloc(size);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+	return counted_alloc(size);
+}
+
+void operator delete(void *p) noexcept
+{
+	counted_free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	counted_free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	counted_free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	counted_free(p);
+}
+
+void operator delete(void *p, const nothrow_t &) noexcept
+{
+	counted_free(p);
+}
+
+void operator delete[](void *p, const nothrow_t &) noexcept
+{
+	counted_free(p);
+}
+
+namespace
+{
+
+const HighwayMap &bench_map()
+{
+	static HighwayMap map;
+	if (map.size() == 0 && !map.load("../data/highway_map.csv") && !map.load("data/highway_map.csv"))
+	{
+		cerr << "planner_bench: cannot read highway_map.csv" << endl;
+		exit(1);
+	}
+	return map;
+}
+
+// allocations per iteration since start, call after the benchmark loop
+class AllocationCounter
+{
+public:
+	AllocationCounter() : start(allocations.load()) {}
+	void report(benchmark::State &state)
+	{
+		state.counters["allocs/op"] = benchmark::Counter(
+			(double)(allocations.load() - start), benchmark::Counter::kAvgIterations);
+	}
+private:
+	long start;
+};
+
+// points spread around the whole track, a few meters off the centre line
+void track_points(int n, vector<double> &x, vector<double> &y, vector<double> &theta)
+{
+	const HighwayMap &map = bench_map();
+	mt19937 gen(42);
+	uniform_real_distribution<double> s_dist(0, map.max_s);
+	uniform_real_distribution<double> d_dist(0, 12);
+	for (int i = 0; i < n; i++)
+	{
+		double s = s_dist(gen);
+		vector<double> p = map.getXYSmooth(s, d_dist(gen));
+		vector<double> q = map.getXYSmooth(s + 1, 6);
+		x.push_back(p[0]);
+		y.push_back(p[1]);
+		theta.push_back(atan2(q[1] - p[1], q[0] - p[0]));
+	}
+}
+
+// 5 anchors like the planner's: two behind the car, then 40/80/120m ahead
+void spline_anchors(vector<double> &x, vector<double> &y)
+{
+	x = { -1.0, 0.0, 40.0, 80.0, 120.0 };
+	y = { 0.0, 0.0, 1.5, 3.8, 4.0 };
+}
+
+void BM_ClosestWaypoint(benchmark::State &state)
+{
+	const HighwayMap &map = bench_map();
+	vector<double> x, y, theta;
+	track_points(1024, x, y, theta);
+	AllocationCounter allocs;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		int hint = -1;
+		benchmark::DoNotOptimize(map.ClosestWaypoint(x[i], y[i], hint));
+		i = (i + 1) % x.size();
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_ClosestWaypoint);
+
+// consecutive positions along a lane, as one car produces them tick after tick
+void BM_ClosestWaypointHinted(benchmark::State &state)
+{
+	const HighwayMap &map = bench_map();
+	vector<double> x, y;
+	for (double s = 0; s < map.max_s; s += 0.5)
+	{
+		vector<double> p = map.getXYSmooth(s, 6);
+		x.push_back(p[0]);
+		y.push_back(p[1]);
+	}
+	AllocationCounter allocs;
+	int hint = -1;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(map.ClosestWaypoint(x[i], y[i], hint));
+		i = (i + 1) % x.size();
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_ClosestWaypointHinted);
+
+void BM_GetFrenet(benchmark::State &state)
+{
+	const HighwayMap &map = bench_map();
+	vector<double> x, y, theta;
+	track_points(1024, x, y, theta);
+	AllocationCounter allocs;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		int hint = -1;
+		benchmark::DoNotOptimize(map.getFrenet(x[i], y[i], theta[i], hint));
+		i = (i + 1) % x.size();
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_GetFrenet);
+
+void BM_GetFrenetSmooth(benchmark::State &state)
+{
+	const HighwayMap &map = bench_map();
+	vector<double> x, y, theta;
+	track_points(1024, x, y, theta);
+	AllocationCounter allocs;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		int hint = -1;
+		benchmark::DoNotOptimize(map.getFrenetSmooth(x[i], y[i], theta[i], hint));
+		i = (i + 1) % x.size();
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_GetFrenetSmooth);
+
+void BM_GetXY(benchmark::State &state)
+{
+	const HighwayMap &map = bench_map();
+	AllocationCounter allocs;
+	double s = 0;
+	for (auto _ : state)
+	{
+		double x;
+		double y;
+		int cursor = -1;
+		map.getXY(s, 6, cursor, x, y);
+		benchmark::DoNotOptimize(x);
+		benchmark::DoNotOptimize(y);
+		s = fmod(s + 37.3, map.max_s);
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_GetXY);
+
+// a whole horizon of samples per call, items/s is conversions per second
+void BM_GetXYBatch(benchmark::State &state)
+{
+	const HighwayMap &map = bench_map();
+	int n = state.range(0);
+	vector<double> s(n), d(n, 6), x, y;
+	for (int i = 0; i < n; i++)
+	{
+		s[i] = 6800 + i * 0.4;
+	}
+	map.getXY(s, d, x, y);
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		map.getXY(s, d, x, y);
+		benchmark::DoNotOptimize(x.data());
+	}
+	allocs.report(state);
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_GetXYBatch)->Arg(80)->Arg(1000);
+
+void BM_GetXYSmooth(benchmark::State &state)
+{
+	const HighwayMap &map = bench_map();
+	AllocationCounter allocs;
+	double s = 0;
+	for (auto _ : state)
+	{
+		double x;
+		double y;
+		map.getXYSmooth(s, 6, x, y);
+		benchmark::DoNotOptimize(x);
+		benchmark::DoNotOptimize(y);
+		s = fmod(s + 37.3, map.max_s);
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_GetXYSmooth);
+
+void BM_SplineSetPoints(benchmark::State &state)
+{
+	vector<double> x, y;
+	spline_anchors(x, y);
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		tk::spline s;
+		s.set_points(x, y);
+		benchmark::DoNotOptimize(&s);
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_SplineSetPoints);
+
+void BM_SmallSplineSetPoints(benchmark::State &state)
+{
+	vector<double> x, y;
+	spline_anchors(x, y);
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		tk::small_spline<8> s;
+		s.set_points(x, y);
+		benchmark::DoNotOptimize(&s);
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_SmallSplineSetPoints);
+
+void BM_FixedSplineSetPoints(benchmark::State &state)
+{
+	vector<double> x, y;
+	spline_anchors(x, y);
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		tk::fixed_spline<5> s;
+		s.set_points(&x[0], &y[0]);
+		benchmark::DoNotOptimize(&s);
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_FixedSplineSetPoints);
+
+void BM_SplineEval(benchmark::State &state)
+{
+	vector<double> x, y;
+	spline_anchors(x, y);
+	tk::spline s;
+	s.set_points(x, y);
+	AllocationCounter allocs;
+	double px = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(s(px));
+		px += 0.4;
+		if (px > 120)
+		{
+			px = 0;
+		}
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_SplineEval);
+
+void BM_JmtSolve(benchmark::State &state)
+{
+	JmtSolver solver(3.0);
+	double start[3] = { 120, 20, 0.5 };
+	double end[3] = { 185, 22, 0 };
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		Quintic q = solver.solve(start, end);
+		benchmark::DoNotOptimize(q.a[5]);
+		end[0] += 0.001;
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_JmtSolve);
+
+// A tick's worth of s and d quintics: end speeds x end lanes x horizons,
+// with the jerk bound checked on each.
+void BM_JmtCandidates(benchmark::State &state)
+{
+	const double horizons[] = { 1.5, 2, 2.5, 3, 3.5, 4, 4.5, 5 };
+	JmtTable table(horizons, 8);
+	double s0[3] = { 120, 20, 0.5 };
+	double d0[3] = { 6, 0, 0 };
+	int n = 0;
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		int feasible = 0;
+		for (int h = 0; h < table.size(); h++)
+		{
+			const JmtSolver &solver = table[h];
+			double T = solver.duration();
+			for (int v = 0; v < 50; v++)
+			{
+				double speed = 0.5 * v;
+				double s1[3] = { s0[0] + 0.5 * (s0[1] + speed) * T, speed, 0 };
+				Quintic s = solver.solve(s0, s1);
+				for (int lane = 0; lane < 3; lane++)
+				{
+					double d1[3] = { 2 + 4.0 * lane, 0, 0 };
+					Quintic d = solver.solve(d0, d1);
+					feasible += max(max_jerk(s, T), max_jerk(d, T)) < 10;
+				}
+			}
+		}
+		n = table.size() * 50 * 4;
+		benchmark::DoNotOptimize(feasible);
+	}
+	allocs.report(state);
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_JmtCandidates);
+
+// 300 ego paths of 60 steps each against 40 cars in the two outer lanes. The
+// paths stay in the middle lane, so every step is tested against all cars.
+void BM_CollisionCheck(benchmark::State &state)
+{
+	const int steps = 60;
+	const int cars = 40;
+	const int paths = 300;
+	TrafficOccupancy occupancy;
+	occupancy.reset(steps, cars);
+	for (int t = 0; t < steps; t++)
+	{
+		for (int n = 0; n < cars; n++)
+		{
+			OrientedBox car = { 15.0 * n + 20 * t * 0.1, 2 + 8.0 * (n % 2), 1, 0, 4, 1.15 };
+			occupancy.set(t, n, car);
+		}
+	}
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		int clear = 0;
+		for (int p = 0; p < paths; p++)
+		{
+			double clearance = 20;
+			bool ok = true;
+			for (int t = 0; t < steps && ok; t++)
+			{
+				OrientedBox ego = { 0.5 * t + 0.01 * p, 6 + 0.001 * p, 1, 0, 4, 1.15 };
+				ok = occupancy.clear(t, ego, clearance);
+			}
+			clear += ok;
+		}
+		benchmark::DoNotOptimize(clear);
+	}
+	allocs.report(state);
+	state.SetItemsProcessed(state.iterations() * paths * steps * cars);
+}
+BENCHMARK(BM_CollisionCheck);
+
+// speeds of a full path behind a slower car, from cruising with some braking
+void BM_VelocityProfile(benchmark::State &state)
+{
+	VelocityProfile profile;
+	LeadVehicle lead = { 45, 16 };
+	double speeds[80];
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		profile.plan(21.5, -1.0, 22, &lead, 80, speeds);
+		benchmark::DoNotOptimize(speeds);
+	}
+	allocs.report(state);
+	state.SetItemsProcessed(state.iterations() * 80);
+}
+BENCHMARK(BM_VelocityProfile);
+
+// 80 increasing points through a path spline, one call per point against
+// one batch with derivatives
+void BM_SmallSplineEval(benchmark::State &state)
+{
+	vector<double> x, y;
+	spline_anchors(x, y);
+	tk::small_spline<8> s;
+	s.set_points(x, y);
+	double px[80];
+	for (int i = 0; i < 80; i++)
+	{
+		px[i] = 0.5 * i;
+	}
+	double out[80];
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		for (int i = 0; i < 80; i++)
+		{
+			out[i] = s(px[i]);
+		}
+		benchmark::DoNotOptimize(out);
+	}
+	allocs.report(state);
+	state.SetItemsProcessed(state.iterations() * 80);
+}
+BENCHMARK(BM_SmallSplineEval);
+
+void BM_FixedSplineEval(benchmark::State &state)
+{
+	vector<double> x, y;
+	spline_anchors(x, y);
+	tk::fixed_spline<5> s;
+	s.set_points(&x[0], &y[0]);
+	double px[80];
+	for (int i = 0; i < 80; i++)
+	{
+		px[i] = 0.5 * i;
+	}
+	double out[80];
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		for (int i = 0; i < 80; i++)
+		{
+			out[i] = s(px[i]);
+		}
+		benchmark::DoNotOptimize(out);
+	}
+	allocs.report(state);
+	state.SetItemsProcessed(state.iterations() * 80);
+}
+BENCHMARK(BM_FixedSplineEval);
+
+void BM_SmallSplineEvalSorted(benchmark::State &state)
+{
+	vector<double> x, y;
+	spline_anchors(x, y);
+	tk::small_spline<8> s;
+	s.set_points(x, y);
+	double px[80];
+	for (int i = 0; i < 80; i++)
+	{
+		px[i] = 0.5 * i;
+	}
+	double out[80];
+	double slope[80];
+	double curvature[80];
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		s.eval_sorted(px, 80, out, slope, curvature);
+		benchmark::DoNotOptimize(out);
+		benchmark::DoNotOptimize(slope);
+		benchmark::DoNotOptimize(curvature);
+	}
+	allocs.report(state);
+	state.SetItemsProcessed(state.iterations() * 80);
+}
+BENCHMARK(BM_SmallSplineEvalSorted);
+
+// ---------------------------------------------------------------------
+// per tick cycle
+// ---------------------------------------------------------------------
+
+// Drives the planner in closed loop against the built-in simulator and keeps
+// every telemetry frame it produced, so the macro benchmark replays a
+// realistic sequence of messages.
+const vector<string> &recorded_drive()
+{
+	static vector<string> frames;
+	if (!frames.empty())
+	{
+		return frames;
+	}
+
+	const HighwayMap &map = bench_map();
+	HighwaySimulator sim(map, SimulatorConfig());
+	Planner planner(map);
+	frames.resize(2000);
+	for (size_t tick = 0; tick < frames.size(); tick++)
+	{
+		write_telemetry_frame(sim.telemetry(), frames[tick]);
+		const Trajectory &path = planner.step(sim.telemetry());
+		sim.advance(path.x, path.y, path.size);
+	}
+	return frames;
+}
+
+void BM_ParseTelemetry(benchmark::State &state)
+{
+	const vector<string> &frames = recorded_drive();
+	unique_ptr<Telemetry> t(new Telemetry);
+	AllocationCounter allocs;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(parse_telemetry(frames[i].data(), frames[i].size(), *t));
+		i = (i + 1) % frames.size();
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_ParseTelemetry);
+
+void BM_WriteControl(benchmark::State &state)
+{
+	vector<double> x(80), y(80);
+	for (int i = 0; i < 80; i++)
+	{
+		x[i] = 909.48 + i * 0.4403;
+		y[i] = 1128.67 + i * 0.0123;
+	}
+	ControlWriter writer(Telemetry::MAX_PATH);
+	AllocationCounter allocs;
+	for (auto _ : state)
+	{
+		writer.write(x, y);
+		benchmark::DoNotOptimize(writer.data());
+	}
+	allocs.report(state);
+}
+BENCHMARK(BM_WriteControl);
+
+// Full cycle per recorded frame: decode, plan, serialize. Reports the tick
+// latency distribution next to the mean.
+void BM_PlannerTick(benchmark::State &state)
+{
+	const HighwayMap &map = bench_map();
+	const vector<string> &frames = recorded_drive();
+	Planner planner(map);
+	unique_ptr<Telemetry> t(new Telemetry);
+	ControlWriter writer(Telemetry::MAX_PATH);
+
+	vector<double> latencies;
+	latencies.reserve(1 << 20);
+
+	AllocationCounter allocs;
+	size_t i = 0;
+	for (auto _ : state)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+		parse_telemetry(frames[i].data(), frames[i].size(), *t);
+		const Trajectory &path = planner.step(*t);
+		writer.write(path.x, path.y, path.size);
+		benchmark::DoNotOptimize(writer.data());
+
+		chrono::steady_clock::time_point end = chrono::steady_clock::now();
+		if (latencies.size() < latencies.capacity())
+		{
+			latencies.push_back(chrono::duration<double, std::micro>(end - start).count());
+		}
+		i = (i + 1) % frames.size();
+	}
+	allocs.report(state);
+
+	if (!latencies.empty())
+	{
+		sort(latencies.begin(), latencies.end());
+		state.counters["p50_us"] = latencies[latencies.size() / 2];
+		state.counters["p99_us"] = latencies[(latencies.size() * 99) / 100];
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PlannerTick);
+
+// ---------------------------------------------------------------------
+// checks against the reference implementations, for --check
+// ---------------------------------------------------------------------
+
+// counts the mismatches of one check and prints the first few
+class Mismatches
+{
+public:
+	explicit Mismatches(const char *check) : check(check), count(0), total(0) {}
+
+	void expect(bool ok, const string &what)
+	{
+		total++;
+		if (!ok && count++ < 10)
+		{
+			cerr << check << ": " << what << endl;
+		}
+	}
+
+	// prints the summary, the number of mismatches
+	int report() const
+	{
+		cout << check << ": " << total << " cases, " << count << " mismatches" << endl;
+		return count;
+	}
+
+private:
+	const char *check;
+	long count;
+	long total;
+};
+
+bool same_bits(double a, double b)
+{
+	return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+// random doubles of every kind: short decimals, track coordinates, whole
+// magnitudes from subnormal to huge, and any finite bit pattern
+double random_double(mt19937_64 &gen)
+{
+	double value;
+	uint64_t bits = gen();
+	switch (bits % 4)
+	{
+	case 0:
+		return (double)(gen() % 1000000) / 100.0 - 5000;
+	case 1:
+		return (double)(gen() % 2000000) - 1e6 + (double)(gen() % 1000000000) / 1e9;
+	case 2:
+		return ldexp((double)(gen() >> 11), -53) * pow(10.0, (int)(gen() % 600) - 300);
+	default:
+		bits = gen();
+		memcpy(&value, &bits, sizeof(double));
+		return isfinite(value) ? value : 0.0;
+	}
+}
+
+// The telemetry parser reads every number exactly as strtod does: frames
+// whose previous path holds numbers printed in many ways, and the halfway
+// and boundary cases of the conversion.
+int check_parser()
+{
+	Mismatches mismatches("parser");
+	mt19937_64 gen(5);
+	unique_ptr<Telemetry> t(new Telemetry);
+
+	const char *hard[] = {
+		"9007199254740993", "9007199254740993.0", "9007199254740992.000000000001",
+		"2.2250738585072014e-308", "2.2250738585072011e-308", "4.9406564584124654e-324",
+		"1.7976931348623157e308", "8.98846567431158e307", "0.1", "1e23", "-821.0936127106909",
+		"1.0000000000000001110223024625156540423631668090820312500001", "0", "-0", "0.0",
+		"1e-64", "1e64", "7.2057594037927933e16", "123456789012345678901234567890", "1E5",
+		"2.5e-324", "2.4703282292062327e-324", "-1.5e+300"
+	};
+	const int num_hard = sizeof(hard) / sizeof(hard[0]);
+
+	vector<string> texts;
+	string frame;
+	for (int round = 0; round < 1000; round++)
+	{
+		texts.clear();
+		if (round == 0)
+		{
+			texts.assign(hard, hard + num_hard);
+		}
+		char text[64];
+		while ((int)texts.size() < Telemetry::MAX_PATH)
+		{
+			double value = random_double(gen);
+			switch (gen() % 4)
+			{
+			case 0:
+				snprintf(text, sizeof(text), "%.17g", value);
+				break;
+			case 1:
+				snprintf(text, sizeof(text), "%.*g", 1 + (int)(gen() % 16), value);
+				break;
+			case 2:
+				snprintf(text, sizeof(text), "%.*e", (int)(gen() % 20), value);
+				break;
+			default:
+				snprintf(text, sizeof(text), "%.*f", (int)(gen() % 12), fmod(value, 1e12));
+				break;
+			}
+			texts.push_back(text);
+		}
+
+		frame = "42[\"telemetry\",{\"x\":0,\"y\":0,\"yaw\":0,\"speed\":0,\"s\":0,\"d\":0,\"previous_path_x\":[";
+		for (size_t i = 0; i < texts.size(); i++)
+		{
+			frame += (i > 0 ? "," : "") + texts[i];
+		}
+		frame += "],\"previous_path_y\":[";
+		for (size_t i = 0; i < texts.size(); i++)
+		{
+			frame += (i > 0 ? "," : "") + texts[texts.size() - 1 - i];
+		}
+		frame += "],\"end_path_s\":0,\"end_path_d\":0,\"sensor_fusion\":[]}]";
+
+		if (parse_telemetry(frame.data(), frame.size(), *t) != TELEMETRY_OK ||
+		    t->previous_path_size != (int)texts.size())
+		{
+			mismatches.expect(false, "frame not parsed: " + frame.substr(0, 120));
+			continue;
+		}
+		for (size_t i = 0; i < texts.size(); i++)
+		{
+			double expected = strtod(texts[i].c_str(), NULL);
+			double back = strtod(texts[texts.size() - 1 - i].c_str(), NULL);
+			char got[96];
+			snprintf(got, sizeof(got), " read as %.17g, strtod %.17g", t->previous_path_x[i], expected);
+			mismatches.expect(same_bits(t->previous_path_x[i], expected), texts[i] + got);
+			mismatches.expect(same_bits(t->previous_path_y[i], back), texts[texts.size() - 1 - i]);
+		}
+	}
+	return mismatches.report();
+}
+
+// significant digits of a formatted number, without the leading and
+// trailing zeros that only place the point
+int significant_digits(const char *text)
+{
+	string digits;
+	for (const char *c = text; *c && *c != 'e' && *c != 'E'; c++)
+	{
+		if (*c >= '0' && *c <= '9')
+		{
+			digits += *c;
+		}
+	}
+	size_t first = digits.find_first_not_of('0');
+	if (first == string::npos)
+	{
+		return 1;
+	}
+	return (int)(digits.find_last_not_of('0') - first + 1);
+}
+
+// The control formatter writes the shortest decimal that reads back to the
+// same double: strtod of the text gives the same bits, and one digit less
+// rounded to nearest does not. The whole reply also parses back exactly.
+int check_formatter()
+{
+	Mismatches mismatches("formatter");
+	mt19937_64 gen(6);
+
+	const double hard[] = { 0.0, -0.0, 0.1, 0.3, 1e23, 5e-324, 2.2250738585072014e-308,
+		1.7976931348623157e308, 9007199254740993.0, 123456.0, 1e21, 1e-7, 909.48, 1128.67 };
+	const int num_hard = sizeof(hard) / sizeof(hard[0]);
+
+	for (int i = 0; i < 500000; i++)
+	{
+		double value = i < num_hard ? hard[i] : random_double(gen);
+		char text[32];
+		int length = ControlWriter::format_double(value, text);
+		text[length] = 0;
+
+		char got[96];
+		snprintf(got, sizeof(got), " for %.17g", value);
+		mismatches.expect(same_bits(strtod(text, NULL), value), string("no round trip: ") + text + got);
+
+		int digits = min(significant_digits(text), 18);
+		if (digits > 1)
+		{
+			char shorter[40];
+			snprintf(shorter, sizeof(shorter), "%.*g", digits - 1, value);
+			mismatches.expect(!same_bits(strtod(shorter, NULL), value),
+			                  string("not shortest: ") + text + " but " + shorter + got);
+		}
+	}
+
+	ControlWriter writer(Telemetry::MAX_PATH);
+	vector<double> x(Telemetry::MAX_PATH), y(Telemetry::MAX_PATH);
+	double next_x[Telemetry::MAX_PATH];
+	double next_y[Telemetry::MAX_PATH];
+	for (int round = 0; round < 200; round++)
+	{
+		for (int i = 0; i < Telemetry::MAX_PATH; i++)
+		{
+			x[i] = random_double(gen);
+			y[i] = random_double(gen);
+		}
+		writer.write(x, y);
+		int count = 0;
+		bool parsed = parse_control(writer.data(), writer.length(), next_x, next_y, Telemetry::MAX_PATH, count);
+		mismatches.expect(parsed && count == Telemetry::MAX_PATH, "reply not parsed");
+		for (int i = 0; parsed && i < count; i++)
+		{
+			mismatches.expect(same_bits(next_x[i], x[i]) && same_bits(next_y[i], y[i]), "reply point changed");
+		}
+	}
+	return mismatches.report();
+}
+
+// strictly increasing knots a few to tens of metres apart, like the path
+// anchors, with offsets of a few metres
+void random_knots(mt19937_64 &gen, int n, double *x, double *y)
+{
+	uniform_real_distribution<double> gap(0.01, 50);
+	uniform_real_distribution<double> offset(-10, 10);
+	x[0] = offset(gen) * 5;
+	y[0] = offset(gen);
+	for (int i = 1; i < n; i++)
+	{
+		x[i] = x[i - 1] + gap(gen);
+		y[i] = offset(gen);
+	}
+}
+
+// x to evaluate a spline at: on the knots, between them and past both ends,
+// increasing for eval_sorted()
+void evaluation_points(mt19937_64 &gen, const double *knots, int n, vector<double> &x)
+{
+	uniform_real_distribution<double> where(knots[0] - 20, knots[n - 1] + 20);
+	x.assign(knots, knots + n);
+	for (int i = 0; i < 64; i++)
+	{
+		x.push_back(where(gen));
+	}
+	sort(x.begin(), x.end());
+}
+
+// small_spline gives the bits of tk::spline for any number of points it
+// holds, through operator() and eval_sorted(), with both boundary types.
+int check_small_spline()
+{
+	Mismatches mismatches("small_spline");
+	mt19937_64 gen(21);
+	vector<double> px, py, at;
+	double values[128];
+	for (int round = 0; round < 20000; round++)
+	{
+		int n = 3 + round % 6;
+		px.resize(n);
+		py.resize(n);
+		random_knots(gen, n, &px[0], &py[0]);
+
+		tk::spline reference;
+		tk::small_spline<8> small;
+		if (round % 3 == 1)
+		{
+			// slopes given at both ends, extrapolating linearly
+			reference.set_boundary(tk::spline::first_deriv, 0.5, tk::spline::first_deriv, -0.25, true);
+			small.set_boundary(tk::small_spline<8>::first_deriv, 0.5, tk::small_spline<8>::first_deriv, -0.25, true);
+		}
+		reference.set_points(px, py);
+		small.set_points(px, py);
+
+		evaluation_points(gen, &px[0], n, at);
+		small.eval_sorted(&at[0], (int)at.size(), values);
+		for (size_t i = 0; i < at.size(); i++)
+		{
+			double expected = reference(at[i]);
+			bool ok = same_bits(small(at[i]), expected) && same_bits(values[i], expected);
+			char what[128] = "";
+			if (!ok)
+			{
+				snprintf(what, sizeof(what), "%d points at %.17g: %.17g, tk::spline %.17g", n, at[i],
+				         small(at[i]), expected);
+			}
+			mismatches.expect(ok, what);
+		}
+	}
+	return mismatches.report();
+}
+
+// fixed_spline gives the bits of tk::spline with its default boundaries,
+// for the five points of the planner's path spline.
+int check_fixed_spline()
+{
+	Mismatches mismatches("fixed_spline");
+	mt19937_64 gen(23);
+	vector<double> px(5), py(5), at;
+	double values[128];
+	for (int round = 0; round < 20000; round++)
+	{
+		random_knots(gen, 5, &px[0], &py[0]);
+
+		tk::spline reference;
+		tk::fixed_spline<5> fixed;
+		reference.set_points(px, py);
+		fixed.set_points(&px[0], &py[0]);
+
+		evaluation_points(gen, &px[0], 5, at);
+		fixed.eval_sorted(&at[0], (int)at.size(), values);
+		for (size_t i = 0; i < at.size(); i++)
+		{
+			double expected = reference(at[i]);
+			bool ok = same_bits(fixed(at[i]), expected) && same_bits(values[i], expected);
+			char what[128] = "";
+			if (!ok)
+			{
+				snprintf(what, sizeof(what), "at %.17g: %.17g, tk::spline %.17g", at[i], fixed(at[i]), expected);
+			}
+			mismatches.expect(ok, what);
+		}
+	}
+	return mismatches.report();
+}
+
+int run_checks()
+{
+	int failed = 0;
+	failed += check_parser() > 0;
+	failed += check_formatter() > 0;
+	failed += check_small_spline() > 0;
+	failed += check_fixed_spline() > 0;
+	return failed > 0 ? 1 : 0;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--check") == 0)
+		{
+			return run_checks();
+		}
+	}
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	return 0;
+}
@@ -0,0 +1,209 @@
+#include "prediction.h"
+#include <algorithm>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+
+// weight of the newest lateral speed measurement
+const double lateral_smoothing = 0.5;
+
+// lateral speed that counts as a lane change rather than drift, m/s
+const double intent_speed = 0.4;
+
+// One pass over the columns: speed along the road direction (tx, ty) and
+// floor(d / lane_width) of every car. Uses SSE2 two cars at a time where
+// available, with the same operations as the scalar tail.
+void scan_cars(const SensorFusion &cars, const double *tx, const double *ty, double lane_width,
+               double *s_dot, int *lane)
+{
+	int n = cars.size;
+	int i = 0;
+#ifdef __SSE2__
+	const __m128d width = _mm_set1_pd(lane_width);
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128d x = _mm_loadu_pd(tx + i);
+		__m128d y = _mm_loadu_pd(ty + i);
+		__m128d along = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(cars.vx + i), x), _mm_mul_pd(_mm_loadu_pd(cars.vy + i), y));
+		__m128d norm = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y)));
+		_mm_storeu_pd(s_dot + i, _mm_div_pd(along, norm));
+
+		// floor for the two lane numbers: truncate, then step down where that rounded up
+		__m128d d = _mm_div_pd(_mm_loadu_pd(cars.d + i), width);
+		__m128i truncated = _mm_cvttpd_epi32(d);
+		__m128d back = _mm_cvtepi32_pd(truncated);
+		__m128i fix = _mm_castpd_si128(_mm_cmpgt_pd(back, d));
+		fix = _mm_shuffle_epi32(fix, _MM_SHUFFLE(3, 3, 2, 0));
+		__m128i floored = _mm_add_epi32(truncated, fix);
+		lane[i] = _mm_cvtsi128_si32(floored);
+		lane[i + 1] = _mm_cvtsi128_si32(_mm_shuffle_epi32(floored, _MM_SHUFFLE(1, 1, 1, 1)));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		s_dot[i] = (cars.vx[i] * tx[i] + cars.vy[i] * ty[i]) / sqrt(tx[i] * tx[i] + ty[i] * ty[i]);
+		lane[i] = (int)floor(cars.d[i] / lane_width);
+	}
+}
+
+}
+
+Prediction::Prediction(const HighwayMap &map) : map(map), num_steps(0)
+{
+}
+
+void Prediction::reset()
+{
+	tracks.clear();
+	previous.clear();
+	by_id.clear();
+	num_steps = 0;
+}
+
+void Prediction::update(const SensorFusion &cars, double dt)
+{
+	// look up last tick's tracks by id
+	tracks.swap(previous);
+	by_id.resize(previous.size());
+	for (size_t i = 0; i < previous.size(); i++)
+	{
+		by_id[i] = make_pair(previous[i].id, (int)i);
+	}
+	sort(by_id.begin(), by_id.end());
+
+	int n = cars.size;
+	tracks.resize(n);
+	car_x.assign(cars.x, cars.x + n);
+	car_y.assign(cars.y, cars.y + n);
+	car_vx.assign(cars.vx, cars.vx + n);
+	car_vy.assign(cars.vy, cars.vy + n);
+
+	// speed along the road from the velocity and the road direction at the
+	// car, which is square to the fitted normal
+	road_x.resize(n);
+	road_y.resize(n);
+	car_s_dot.resize(n);
+	car_lane.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		double dx, dy;
+		map.normal_smooth(cars.s[i], dx, dy);
+		road_x[i] = -dy;
+		road_y[i] = dx;
+	}
+	if (n > 0)
+	{
+		scan_cars(cars, &road_x[0], &road_y[0], map.lane_width, &car_s_dot[0], &car_lane[0]);
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		Track &t = tracks[i];
+		t.id = (int)cars.id[i];
+		t.s = cars.s[i];
+		t.d = cars.d[i];
+		t.lane = car_lane[i];
+		t.s_dot = car_s_dot[i];
+
+		// the lateral speed only shows in the change of d between ticks
+		vector<pair<int, int> >::const_iterator found =
+			lower_bound(by_id.begin(), by_id.end(), make_pair(t.id, -1));
+		if (found != by_id.end() && found->first == t.id && dt > 0)
+		{
+			const Track &last = previous[found->second];
+			double measured = (t.d - last.d) / dt;
+			t.d_dot = lateral_smoothing * measured + (1 - lateral_smoothing) * last.d_dot;
+			t.age = last.age + 1;
+		}
+		else
+		{
+			t.d_dot = 0;
+			t.age = 1;
+		}
+
+		// heading for the neighbouring lane once it moves sideways fast enough
+		t.intent = t.d_dot > intent_speed ? 1 : (t.d_dot < -intent_speed ? -1 : 0);
+		t.target = t.lane;
+		if (t.intent != 0)
+		{
+			double edge = t.intent * (map.lane_width / 2 + 1e-6);
+			t.target = (int)floor((t.d + edge) / map.lane_width);
+			t.target = max(0, min(map.num_lanes - 1, t.target));
+		}
+	}
+}
+
+void Prediction::predict(double step, int steps, double s, double range)
+{
+	num_steps = steps;
+	size_t n = tracks.size() * steps;
+	path_s.resize(n);
+	path_d.resize(n);
+	path_x.resize(n);
+	path_y.resize(n);
+	path_cos.resize(n);
+	path_sin.resize(n);
+	in_range.resize(tracks.size());
+
+	for (size_t i = 0; i < tracks.size(); i++)
+	{
+		const Track &t = tracks[i];
+		double gap = t.s - s;
+		gap -= map.max_s * floor(gap / map.max_s + 0.5);
+		in_range[i] = fabs(gap) < range;
+		if (!in_range[i])
+		{
+			continue;
+		}
+
+		double center = map.lane_center(t.target);
+		double lateral = fabs(t.d_dot);
+		bool on_road = t.lane >= 0 && t.lane < map.num_lanes;
+
+		double last_x = car_x[i];
+		double last_y = car_y[i];
+		double v = sqrt(car_vx[i] * car_vx[i] + car_vy[i] * car_vy[i]);
+		double heading_x = v > 0.5 ? car_vx[i] / v : 1;
+		double heading_y = v > 0.5 ? car_vy[i] / v : 0;
+		for (int k = 0; k < steps; k++)
+		{
+			double time = (k + 1) * step;
+			double ahead = t.s + t.s_dot * time;
+			double d = t.d;
+			if (t.intent != 0 && on_road)
+			{
+				double reach = lateral * time;
+				d += max(-reach, min(reach, center - d));
+			}
+
+			double x, y;
+			map.getXYSmooth(ahead, d, x, y);
+
+			// kept while standing still
+			double dx = x - last_x;
+			double dy = y - last_y;
+			double moved = sqrt(dx * dx + dy * dy);
+			if (moved > 0.05)
+			{
+				heading_x = dx / moved;
+				heading_y = dy / moved;
+			}
+			last_x = x;
+			last_y = y;
+
+			size_t j = i * steps + k;
+			path_s[j] = ahead;
+			path_d[j] = d;
+			path_x[j] = x;
+			path_y[j] = y;
+			path_cos[j] = heading_x;
+			path_sin[j] = heading_y;
+		}
+	}
+}
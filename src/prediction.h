@@ -0,0 +1,84 @@
+#ifndef PREDICTION_H
+#define PREDICTION_H
+
+#include <utility>
+#include <vector>
+#include "highway_map.h"
+#include "sensor_fusion.h"
+
+// What is known about one other car, carried over from tick to tick by id.
+struct Track
+{
+	int id;
+	double s;
+	double d;
+	double s_dot;  // m/s along the road
+	double d_dot;  // m/s across the road, smoothed over the ticks
+	int lane;      // floor(d / lane_width)
+	int intent;    // -1 moving to the lane on the left, +1 to the right, 0 keeping
+	int target;    // lane the car is expected in at the end of the prediction
+	int age;       // consecutive ticks the car has been seen
+};
+
+// Per vehicle tracks built from the sensor fusion rows, and their paths
+// predicted once per tick for every consumer. Tracks are indexed like the
+// rows of the latest update; cars that disappear lose their history.
+class Prediction
+{
+public:
+	explicit Prediction(const HighwayMap &map);
+
+	void reset();
+
+	// new sensor fusion list, dt seconds after the previous one
+	void update(const SensorFusion &cars, double dt);
+
+	// Samples every step seconds, the first one step from now: s from the
+	// speed along the road, d moving into the target lane at the estimated
+	// lateral speed and staying in its centre. The heading is the direction
+	// of travel between samples. Only tracks within range of s along the
+	// road are predicted, the others cannot be reached anyway.
+	void predict(double step, int steps, double s, double range);
+
+	int size() const { return (int)tracks.size(); }
+	const Track &track(int i) const { return tracks[i]; }
+	bool predicted(int i) const { return in_range[i] != 0; }
+
+	int steps() const { return num_steps; }
+	double s(int i, int k) const { return path_s[i * num_steps + k]; }
+	double d(int i, int k) const { return path_d[i * num_steps + k]; }
+	double x(int i, int k) const { return path_x[i * num_steps + k]; }
+	double y(int i, int k) const { return path_y[i * num_steps + k]; }
+	double heading_x(int i, int k) const { return path_cos[i * num_steps + k]; }
+	double heading_y(int i, int k) const { return path_sin[i * num_steps + k]; }
+
+private:
+	const HighwayMap &map;
+
+	std::vector<Track> tracks;
+	std::vector<Track> previous;
+	std::vector<std::pair<int, int> > by_id; // (id, index into previous), sorted
+
+	// world position and velocity of the latest update, for the headings
+	std::vector<double> car_x;
+	std::vector<double> car_y;
+	std::vector<double> car_vx;
+	std::vector<double> car_vy;
+
+	// per car columns of the latest update, scratch for the vectorized pass
+	std::vector<double> road_x; // road direction at the car
+	std::vector<double> road_y;
+	std::vector<double> car_s_dot;
+	std::vector<int> car_lane;
+
+	int num_steps;
+	std::vector<char> in_range;
+	std::vector<double> path_s;
+	std::vector<double> path_d;
+	std::vector<double> path_x;
+	std::vector<double> path_y;
+	std::vector<double> path_cos;
+	std::vector<double> path_sin;
+};
+
+#endif /* PREDICTION_H */
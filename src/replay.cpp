@@ -0,0 +1,213 @@
+// Offline replay of a frame log recorded with `path_planning --record <file>`.
+//
+// Every inbound frame is pushed through the same parse, plan and serialize
+// steps as the server, as fast as possible and without sockets, with one
+// planner per recorded connection. With --verify each reply is compared byte
+// for byte against the one recorded for its connection, so a change to the
+// planner can be checked against a real drive.
+//
+//   ./replay drive.pplog [--verify] [--candidates] [--map ../data/highway_map.csv] [--costs ../data/lane_costs.cfg]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "highway_map.h"
+#include "lane_cost.h"
+#include "session.h"
+#include "telemetry.h"
+#include "telemetry_log.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+	string log_file;
+	string map_file = "../data/highway_map.csv";
+	bool verify = false;
+	bool candidates = false;
+	LaneCostModel costs = default_lane_costs();
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--verify")
+		{
+			verify = true;
+		}
+		else if (arg == "--candidates")
+		{
+			candidates = true;
+		}
+		else if (arg == "--map" && i + 1 < argc)
+		{
+			map_file = argv[++i];
+		}
+		else if (arg == "--costs" && i + 1 < argc)
+		{
+			string error;
+			if (!costs.load(argv[++i], error))
+			{
+				cerr << error << endl;
+				return 1;
+			}
+		}
+		else if (log_file.empty())
+		{
+			log_file = arg;
+		}
+		else
+		{
+			log_file.clear();
+			break;
+		}
+	}
+	if (log_file.empty())
+	{
+		cerr << "usage: replay <log> [--verify] [--candidates] [--map <highway_map.csv>] [--costs <lane_costs.cfg>]" << endl;
+		return 2;
+	}
+
+	HighwayMap map;
+	if (!map.load(map_file))
+	{
+		cerr << "Failed to read " << map_file << endl;
+		return 1;
+	}
+
+	// the whole log is read up front so disk time stays out of the measurement
+	TelemetryLogReader reader;
+	if (!reader.open(log_file))
+	{
+		cerr << "Failed to read " << log_file << endl;
+		return 1;
+	}
+	vector<LogRecord> records;
+	LogRecord record;
+	while (reader.next(record))
+	{
+		records.push_back(record);
+	}
+
+	// the server answers a frame before it reads the next one of the same
+	// connection, other connections' frames may come in between
+	vector<int> recorded_reply(records.size(), -1);
+	unordered_map<uint32_t, size_t> unanswered_frame;
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		uint32_t connection = records[i].connection;
+		if (records[i].direction == LOG_INBOUND)
+		{
+			unanswered_frame[connection] = i;
+			continue;
+		}
+		unordered_map<uint32_t, size_t>::iterator frame = unanswered_frame.find(connection);
+		if (frame != unanswered_frame.end())
+		{
+			recorded_reply[frame->second] = (int)i;
+			unanswered_frame.erase(frame);
+		}
+	}
+
+	// a fresh planner for every connection, as the server gives each socket
+	unordered_map<uint32_t, unique_ptr<Session> > sessions;
+	static const char manual[] = "42[\"manual\",{}]";
+
+	vector<double> latency_us;
+	latency_us.reserve(records.size());
+	int inbound = 0;
+	int mismatches = 0;
+	int unanswered = 0;
+	int malformed = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		if (records[i].direction != LOG_INBOUND)
+		{
+			continue;
+		}
+		inbound++;
+
+		unique_ptr<Session> &session = sessions[records[i].connection];
+		if (!session)
+		{
+			session.reset(new Session(map));
+			session->connection = records[i].connection;
+			session->planner.costs = costs;
+			session->planner.candidates = candidates;
+		}
+
+		const vector<char> &frame = records[i].frame;
+		const char *reply = NULL;
+		size_t reply_length = 0;
+
+		chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+		TelemetryStatus status = parse_telemetry(frame.data(), frame.size(), session->telemetry);
+		if (status == TELEMETRY_OK)
+		{
+			const Trajectory &path = session->planner.step(session->telemetry);
+			session->control.write(path.x, path.y, path.size);
+			reply = session->control.data();
+			reply_length = session->control.length();
+		}
+		else if (status == TELEMETRY_MANUAL)
+		{
+			reply = manual;
+			reply_length = sizeof(manual) - 1;
+		}
+		else if (status == TELEMETRY_ERROR)
+		{
+			// like the server: reported, not answered
+			malformed++;
+		}
+		chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+		latency_us.push_back(chrono::duration<double, micro>(t1 - t0).count());
+
+		if (!verify)
+		{
+			continue;
+		}
+
+		const LogRecord *recorded = recorded_reply[i] >= 0 ? &records[recorded_reply[i]] : NULL;
+		if (!reply)
+		{
+			unanswered += (recorded != NULL);
+			continue;
+		}
+		if (!recorded || recorded->frame.size() != reply_length ||
+			memcmp(recorded->frame.data(), reply, reply_length) != 0)
+		{
+			if (mismatches == 0)
+			{
+				cerr << "first mismatch at inbound frame " << inbound - 1 << " of connection " << records[i].connection << endl;
+			}
+			mismatches++;
+		}
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	printf("%d inbound frames in %.3f s, %.0f frames/s\n", inbound, seconds, inbound / seconds);
+	if (malformed > 0)
+	{
+		cerr << malformed << " malformed telemetry frames, not answered" << endl;
+	}
+	if (!latency_us.empty())
+	{
+		sort(latency_us.begin(), latency_us.end());
+		size_t n = latency_us.size();
+		printf("latency us: p50 %.1f  p99 %.1f  max %.1f\n",
+			latency_us[n / 2], latency_us[min(n - 1, n * 99 / 100)], latency_us[n - 1]);
+	}
+	if (verify)
+	{
+		printf("verify: %d mismatched replies, %d recorded replies not reproduced\n", mismatches, unanswered);
+		return (mismatches == 0 && unanswered == 0) ? 0 : 1;
+	}
+	return 0;
+}
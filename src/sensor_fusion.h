@@ -0,0 +1,20 @@
+#ifndef SENSOR_FUSION_H
+#define SENSOR_FUSION_H
+
+// Sensor fusion list as contiguous columns, one entry per tracked car.
+// The simulator sends rows of [id, x, y, vx, vy, s, d].
+struct SensorFusion
+{
+	static const int MAX_CARS = 256;
+
+	int size;
+	double id[MAX_CARS];
+	double x[MAX_CARS];
+	double y[MAX_CARS];
+	double vx[MAX_CARS];
+	double vy[MAX_CARS];
+	double s[MAX_CARS];
+	double d[MAX_CARS];
+};
+
+#endif /* SENSOR_FUSION_H */
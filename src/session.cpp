@@ -0,0 +1,62 @@
+#include "session.h"
+#include <atomic>
+#include <new>
+
+using namespace std;
+
+namespace
+{
+
+// shared by the pools of all event loops, which record into one log
+atomic<uint32_t> next_connection(0);
+
+}
+
+SessionPool::SessionPool(const HighwayMap &map, int block_size)
+	: map(map), block_size(block_size > 0 ? block_size : 1), constructed(0)
+{
+}
+
+SessionPool::~SessionPool()
+{
+	for (int i = 0; i < constructed; i++)
+	{
+		slot(i)->~Session();
+	}
+}
+
+Session *SessionPool::slot(int i) const
+{
+	return reinterpret_cast<Session *>(&blocks[i / block_size][i % block_size]);
+}
+
+Session *SessionPool::acquire()
+{
+	if (!free_list.empty())
+	{
+		Session *session = free_list.back();
+		free_list.pop_back();
+		session->planner.reset();
+		session->connection = next_connection++;
+		return session;
+	}
+
+	// construct the next slot, adding a block when all are in use
+	if (constructed == capacity())
+	{
+		blocks.push_back(unique_ptr<Slot[]>(new Slot[block_size]));
+		free_list.reserve(capacity());
+	}
+	Session *session = new (slot(constructed)) Session(map);
+	session->connection = next_connection++;
+	constructed++;
+	return session;
+}
+
+void SessionPool::release(Session *session)
+{
+	if (session)
+	{
+		free_list.push_back(session);
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <memory>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+#include "control_writer.h"
+#include "highway_map.h"
+#include "planner.h"
+#include "telemetry.h"
+
+// Everything one connected simulator keeps between two messages.
+struct Session
+{
+	explicit Session(const HighwayMap &map) : planner(map), control(Telemetry::MAX_PATH) {}
+
+	Planner planner;
+	Telemetry telemetry; // decoded in place for every message
+	ControlWriter control; // reply buffer reused for every control message
+	uint32_t connection; // numbers the connections of the process, for the frame log
+};
+
+// Hands out Sessions to connections and takes them back on disconnect.
+// Sessions live in blocks of block_size slots and released ones are reused,
+// so connecting and disconnecting only touches the heap while the pool grows
+// to the peak number of simultaneous connections.
+class SessionPool
+{
+public:
+	explicit SessionPool(const HighwayMap &map, int block_size = 8);
+	~SessionPool();
+
+	// a session with its planner reset for a new drive and the next
+	// connection number of all pools
+	Session *acquire();
+	void release(Session *session);
+
+	int in_use() const { return constructed - (int)free_list.size(); }
+	int capacity() const { return (int)blocks.size() * block_size; }
+
+private:
+	typedef std::aligned_storage<sizeof(Session), alignof(Session)>::type Slot;
+
+	const HighwayMap &map;
+	int block_size;
+	std::vector< std::unique_ptr<Slot[]> > blocks;
+	int constructed; // slots holding a Session, always the first ones
+	std::vector<Session *> free_list;
+
+	Session *slot(int i) const;
+
+	SessionPool(const SessionPool &);
+	SessionPool &operator=(const SessionPool &);
+};
+
+#endif /* SESSION_H */
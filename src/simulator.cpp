@@ -0,0 +1,372 @@
+#include "simulator.h"
+#include <algorithm>
+#include <cstring>
+#include <math.h>
+#include "control_writer.h"
+
+using namespace std;
+
+namespace
+{
+
+const double dt = 0.02;
+const double mph_per_mps = 2.23694;
+
+// rubric limits
+const double speed_limit = 50 / mph_per_mps;
+const double accel_limit = 10;
+const double jerk_limit = 10;
+
+// two cars touch when their centres are closer than this along and across the road
+const double car_length = 4.5;
+const double car_width = 2;
+
+// traffic behaviour
+const double follow_distance = 35;
+const double lateral_speed = 1.5;
+const double traffic_accel = 4;
+
+// simulator start pose
+const double start_s = 124.8336;
+const double start_d = 6.164833;
+
+}
+
+// ds wrapped into [-max_s/2, max_s/2)
+static double wrap_gap(double ds, double max_s)
+{
+	ds = fmod(ds, max_s);
+	if (ds >= max_s / 2)
+	{
+		ds -= max_s;
+	}
+	else if (ds < -max_s / 2)
+	{
+		ds += max_s;
+	}
+	return ds;
+}
+
+HighwaySimulator::HighwaySimulator(const HighwayMap &map, const SimulatorConfig &config)
+	: map(map), config(config), state(new Telemetry),
+	  control_x(Telemetry::MAX_PATH), control_y(Telemetry::MAX_PATH)
+{
+	this->config.cars = min(max(config.cars, 0), (int)SensorFusion::MAX_CARS);
+	this->config.points_per_tick = max(config.points_per_tick, 1);
+	reset();
+}
+
+void HighwaySimulator::reset()
+{
+	random.seed(config.seed);
+	memset(state.get(), 0, sizeof(Telemetry));
+	memset(&stats, 0, sizeof(stats));
+	memset(vel_x, 0, sizeof(vel_x));
+	memset(vel_y, 0, sizeof(vel_y));
+	memset(acc_x, 0, sizeof(acc_x));
+	memset(acc_y, 0, sizeof(acc_y));
+	hint = -1;
+
+	// at rest on the middle lane, facing along the road
+	Telemetry &t = *state;
+	double x1, y1;
+	map.getXYSmooth(start_s, start_d, t.x, t.y);
+	map.getXYSmooth(start_s + 1, start_d, x1, y1);
+	t.yaw = atan2(y1 - t.y, x1 - t.x) * 180 / M_PI;
+	t.s = start_s;
+	t.d = start_d;
+	last_x = t.x;
+	last_y = t.y;
+
+	int n = config.cars;
+	cruise_speed.resize(n);
+	speed.resize(n);
+	target_lane.resize(n);
+	touching.assign(n, 0);
+
+	SensorFusion &cars = t.sensor_fusion;
+	cars.size = 0;
+	for (int i = 0; i < n; i++)
+	{
+		place_car(i);
+		cars.size++;
+	}
+	move_traffic(0);
+}
+
+// random lane and s, clear of the ego car and of the cars placed before
+void HighwaySimulator::place_car(int i)
+{
+	SensorFusion &cars = state->sensor_fusion;
+	uniform_int_distribution<int> lane_dist(0, map.num_lanes - 1);
+	uniform_real_distribution<double> s_dist(0, map.max_s);
+	uniform_real_distribution<double> speed_dist(config.min_speed, config.max_speed);
+
+	int lane = 0;
+	double s = 0;
+	for (int attempt = 0; attempt < 100; attempt++)
+	{
+		lane = lane_dist(random);
+		s = s_dist(random);
+		bool clear = fabs(wrap_gap(s - state->s, map.max_s)) > 30;
+		for (int j = 0; j < i && clear; j++)
+		{
+			clear = target_lane[j] != lane || fabs(wrap_gap(s - cars.s[j], map.max_s)) > 15;
+		}
+		if (clear)
+		{
+			break;
+		}
+	}
+
+	cars.id[i] = i;
+	cars.s[i] = s;
+	cars.d[i] = map.lane_center(lane);
+	target_lane[i] = lane;
+	cruise_speed[i] = speed_dist(random);
+	speed[i] = cruise_speed[i];
+}
+
+void HighwaySimulator::move_traffic(double step)
+{
+	SensorFusion &cars = state->sensor_fusion;
+	const Telemetry &ego = *state;
+	double ego_speed = ego.speed / mph_per_mps;
+	uniform_real_distribution<double> chance(0, 1);
+
+	for (int i = 0; i < cars.size; i++)
+	{
+		// follow the closest car ahead in the same lane, the ego car included
+		double leader_gap = follow_distance;
+		double leader_speed = cruise_speed[i];
+		for (int j = 0; j <= cars.size; j++)
+		{
+			double s = (j < cars.size) ? cars.s[j] : ego.s;
+			double d = (j < cars.size) ? cars.d[j] : ego.d;
+			if (j == i || fabs(d - cars.d[i]) > car_width + 0.5)
+			{
+				continue;
+			}
+			double gap = wrap_gap(s - cars.s[i], map.max_s);
+			if (gap > 0 && gap < leader_gap)
+			{
+				leader_gap = gap;
+				leader_speed = (j < cars.size) ? speed[j] : ego_speed;
+			}
+		}
+		double wanted = min(cruise_speed[i], leader_speed);
+		if (leader_gap < follow_distance / 3)
+		{
+			wanted = min(wanted, 0.8 * leader_speed);
+		}
+		double max_change = traffic_accel * step;
+		speed[i] += max(-max_change, min(max_change, wanted - speed[i]));
+
+		// start a lane change now and then when the neighbouring lane is free
+		double center = map.lane_center(target_lane[i]);
+		if (step > 0 && fabs(cars.d[i] - center) < 1e-9 && chance(random) < config.lane_change_rate * step)
+		{
+			int lane = target_lane[i] + (chance(random) < 0.5 ? -1 : 1);
+			bool clear = lane >= 0 && lane < map.num_lanes;
+			double lane_d = map.lane_center(lane);
+			for (int j = 0; j <= cars.size && clear; j++)
+			{
+				double s = (j < cars.size) ? cars.s[j] : ego.s;
+				double d = (j < cars.size) ? cars.d[j] : ego.d;
+				double gap = wrap_gap(s - cars.s[i], map.max_s);
+				clear = j == i || fabs(d - lane_d) > car_width + 0.5 || gap < -15 || gap > 20;
+			}
+			if (clear)
+			{
+				target_lane[i] = lane;
+				center = lane_d;
+			}
+		}
+		double lateral = lateral_speed * step;
+		cars.d[i] += max(-lateral, min(lateral, center - cars.d[i]));
+
+		cars.s[i] = map.wrap_s(cars.s[i] + speed[i] * step);
+
+		double x1, y1;
+		map.getXYSmooth(cars.s[i], cars.d[i], cars.x[i], cars.y[i]);
+		map.getXYSmooth(cars.s[i] + 1, cars.d[i], x1, y1);
+		double heading = atan2(y1 - cars.y[i], x1 - cars.x[i]);
+		cars.vx[i] = speed[i] * cos(heading);
+		cars.vy[i] = speed[i] * sin(heading);
+	}
+}
+
+// one 0.02 s step of the ego car to the next path point
+void HighwaySimulator::drive_to(double x, double y)
+{
+	// velocity and acceleration are compared 10 steps apart, 0.2 s
+	memmove(vel_x, vel_x + 1, (WINDOW - 1) * sizeof(double));
+	memmove(vel_y, vel_y + 1, (WINDOW - 1) * sizeof(double));
+	memmove(acc_x, acc_x + 1, (WINDOW - 1) * sizeof(double));
+	memmove(acc_y, acc_y + 1, (WINDOW - 1) * sizeof(double));
+	vel_x[WINDOW - 1] = (x - last_x) / dt;
+	vel_y[WINDOW - 1] = (y - last_y) / dt;
+	acc_x[WINDOW - 1] = (vel_x[WINDOW - 1] - vel_x[0]) / ((WINDOW - 1) * dt);
+	acc_y[WINDOW - 1] = (vel_y[WINDOW - 1] - vel_y[0]) / ((WINDOW - 1) * dt);
+	double jerk_x = (acc_x[WINDOW - 1] - acc_x[0]) / ((WINDOW - 1) * dt);
+	double jerk_y = (acc_y[WINDOW - 1] - acc_y[0]) / ((WINDOW - 1) * dt);
+	last_x = x;
+	last_y = y;
+
+	double v = sqrt(vel_x[WINDOW - 1] * vel_x[WINDOW - 1] + vel_y[WINDOW - 1] * vel_y[WINDOW - 1]);
+	double a = sqrt(acc_x[WINDOW - 1] * acc_x[WINDOW - 1] + acc_y[WINDOW - 1] * acc_y[WINDOW - 1]);
+	double j = sqrt(jerk_x * jerk_x + jerk_y * jerk_y);
+
+	stats.steps++;
+	stats.speeding_steps += (v > speed_limit);
+	stats.accel_steps += (a > accel_limit);
+	stats.jerk_steps += (j > jerk_limit);
+	stats.max_speed = max(stats.max_speed, v);
+	stats.max_accel = max(stats.max_accel, a);
+	stats.max_jerk = max(stats.max_jerk, j);
+}
+
+void HighwaySimulator::check_contacts()
+{
+	const SensorFusion &cars = state->sensor_fusion;
+	for (int i = 0; i < cars.size; i++)
+	{
+		bool contact = fabs(wrap_gap(cars.s[i] - state->s, map.max_s)) < car_length &&
+			fabs(cars.d[i] - state->d) < car_width;
+		if (contact && !touching[i])
+		{
+			stats.collisions++;
+		}
+		touching[i] = contact;
+	}
+}
+
+void HighwaySimulator::advance(const double *next_x, const double *next_y, int n)
+{
+	Telemetry &t = *state;
+	int steps = config.points_per_tick;
+
+	// the car stays where it is once the path runs out
+	int used = min(n, steps);
+	for (int i = 0; i < steps; i++)
+	{
+		if (i < used)
+		{
+			drive_to(next_x[i], next_y[i]);
+		}
+		else
+		{
+			drive_to(last_x, last_y);
+		}
+	}
+
+	t.previous_path_size = min(n - used, (int)Telemetry::MAX_PATH);
+	memcpy(t.previous_path_x, next_x + used, t.previous_path_size * sizeof(double));
+	memcpy(t.previous_path_y, next_y + used, t.previous_path_size * sizeof(double));
+
+	double vx = vel_x[WINDOW - 1];
+	double vy = vel_y[WINDOW - 1];
+	double v = sqrt(vx * vx + vy * vy);
+	if (v > 0)
+	{
+		t.yaw = atan2(vy, vx) * 180 / M_PI;
+	}
+	t.speed = v * mph_per_mps;
+	t.x = last_x;
+	t.y = last_y;
+
+	double yaw = t.yaw * M_PI / 180;
+	vector<double> frenet = map.getFrenetSmooth(t.x, t.y, yaw, hint);
+	stats.distance += wrap_gap(frenet[0] - t.s, map.max_s);
+	t.s = frenet[0];
+	t.d = frenet[1];
+	if (t.d < 0 || t.d > map.num_lanes * map.lane_width)
+	{
+		stats.offroad_steps += steps;
+	}
+
+	if (t.previous_path_size > 0)
+	{
+		int end_hint = hint;
+		int last = t.previous_path_size - 1;
+		vector<double> end = map.getFrenetSmooth(t.previous_path_x[last], t.previous_path_y[last], yaw, end_hint);
+		t.end_path_s = end[0];
+		t.end_path_d = end[1];
+	}
+	else
+	{
+		t.end_path_s = 0;
+		t.end_path_d = 0;
+	}
+
+	move_traffic(steps * dt);
+	check_contacts();
+}
+
+bool HighwaySimulator::advance(const char *control, size_t length)
+{
+	int n;
+	if (!parse_control(control, length, &control_x[0], &control_y[0], (int)control_x.size(), n))
+	{
+		return false;
+	}
+	advance(control_x.data(), control_y.data(), n);
+	return true;
+}
+
+static void append_number(string &frame, double value)
+{
+	char number[32];
+	frame.append(number, ControlWriter::format_double(value, number));
+}
+
+static void append_array(string &frame, const double *values, int n)
+{
+	frame += '[';
+	for (int i = 0; i < n; i++)
+	{
+		if (i > 0)
+		{
+			frame += ',';
+		}
+		append_number(frame, values[i]);
+	}
+	frame += ']';
+}
+
+void write_telemetry_frame(const Telemetry &t, string &frame)
+{
+	frame.assign("42[\"telemetry\",{\"x\":");
+	append_number(frame, t.x);
+	frame += ",\"y\":";
+	append_number(frame, t.y);
+	frame += ",\"yaw\":";
+	append_number(frame, t.yaw);
+	frame += ",\"speed\":";
+	append_number(frame, t.speed);
+	frame += ",\"s\":";
+	append_number(frame, t.s);
+	frame += ",\"d\":";
+	append_number(frame, t.d);
+	frame += ",\"previous_path_x\":";
+	append_array(frame, t.previous_path_x, t.previous_path_size);
+	frame += ",\"previous_path_y\":";
+	append_array(frame, t.previous_path_y, t.previous_path_size);
+	frame += ",\"end_path_s\":";
+	append_number(frame, t.end_path_s);
+	frame += ",\"end_path_d\":";
+	append_number(frame, t.end_path_d);
+	frame += ",\"sensor_fusion\":[";
+
+	const SensorFusion &cars = t.sensor_fusion;
+	for (int i = 0; i < cars.size; i++)
+	{
+		const double row[7] = { cars.id[i], cars.x[i], cars.y[i], cars.vx[i], cars.vy[i], cars.s[i], cars.d[i] };
+		if (i > 0)
+		{
+			frame += ',';
+		}
+		append_array(frame, row, 7);
+	}
+	frame += "]}]";
+}
@@ -0,0 +1,100 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "highway_map.h"
+#include "telemetry.h"
+
+struct SimulatorConfig
+{
+	int cars;                // traffic cars spread over the lanes
+	unsigned seed;           // traffic placement, speeds and lane changes
+	double min_speed;        // m/s, traffic cruise speeds are drawn from [min_speed, max_speed]
+	double max_speed;
+	int points_per_tick;     // path points the ego drives between two telemetry messages
+	double lane_change_rate; // lane changes per traffic car per second
+
+	SimulatorConfig()
+		: cars(30), seed(1), min_speed(15), max_speed(22), points_per_tick(3), lane_change_rate(0.02) {}
+};
+
+// Counted over every 0.02 s step with the limits of the project rubric.
+struct SimulatorMetrics
+{
+	long steps;          // simulated 0.02 s steps
+	double distance;     // m driven along the track
+	int collisions;      // times the ego car touched another car
+	int speeding_steps;  // above 50 mph
+	int accel_steps;     // total acceleration above 10 m/s^2 over 0.2 s
+	int jerk_steps;      // jerk above 10 m/s^3 over 0.2 s
+	int offroad_steps;   // ego centre outside the lanes of our side
+	double max_speed;    // m/s
+	double max_accel;    // m/s^2
+	double max_jerk;     // m/s^3
+};
+
+// Headless stand-in for the Unity simulator: the ego car follows the points
+// it is sent every 0.02 s and the traffic cruises along the loop, follows the
+// car ahead and changes lanes at random. It can be driven with Trajectory
+// arrays directly or with the same text frames as the websocket.
+class HighwaySimulator
+{
+public:
+	HighwaySimulator(const HighwayMap &map, const SimulatorConfig &config);
+
+	// ego car at the simulator's start pose, traffic drawn from the seed
+	void reset();
+
+	// the message the planner gets next
+	const Telemetry &telemetry() const { return *state; }
+
+	// drive the first points_per_tick points of the path, keep the rest as
+	// previous path and move the traffic by the same time
+	void advance(const double *next_x, const double *next_y, int n);
+
+	// same from a 42["control",...] frame, false if it could not be decoded
+	bool advance(const char *control, size_t length);
+
+	const SimulatorMetrics &metrics() const { return stats; }
+	int laps() const { return (int)(stats.distance / map.max_s); }
+
+private:
+	const HighwayMap &map;
+	SimulatorConfig config;
+	std::mt19937 random;
+
+	std::unique_ptr<Telemetry> state;
+	SimulatorMetrics stats;
+	int hint;
+
+	// per traffic car, indexed like the sensor fusion list
+	std::vector<double> cruise_speed;
+	std::vector<double> speed;
+	std::vector<int> target_lane;
+	std::vector<char> touching;
+
+	// last 11 velocities and accelerations of the ego car, for the 0.2 s windows
+	static const int WINDOW = 11;
+	double vel_x[WINDOW], vel_y[WINDOW];
+	double acc_x[WINDOW], acc_y[WINDOW];
+	double last_x, last_y;
+
+	// scratch for decoded control frames
+	std::vector<double> control_x;
+	std::vector<double> control_y;
+
+	void drive_to(double x, double y);
+	void move_traffic(double dt);
+	void place_car(int i);
+	void check_contacts();
+};
+
+// 42["telemetry",{...}] exactly as the simulator sends it. Numbers use the
+// shortest form that reads back, so a frame decodes to the same Telemetry.
+void write_telemetry_frame(const Telemetry &t, std::string &frame);
+
+#endif /* SIMULATOR_H */
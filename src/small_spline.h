@@ -0,0 +1,214 @@
+/*
+ * small_spline.h
+ *
+ * tk::spline without heap allocations: the points, the coefficients and the
+ * workspace of the tridiagonal solve live in the object, sized for at most
+ * MaxPoints points, and are reused by every set_points().
+ *
+ * Results are bit for bit those of tk::spline: the Thomas algorithm below
+ * performs the same floating point operations in the same order as the
+ * band_matrix LU decomposition with one upper and one lower band.
+ */
+
+#ifndef TK_SMALL_SPLINE_H
+#define TK_SMALL_SPLINE_H
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include "spline_pieces.h"
+
+// same unnamed namespace as spline.h, so tk:: names both
+namespace
+{
+
+namespace tk
+{
+
+// Cubic spline through up to MaxPoints points with the boundary conditions
+// and extrapolation of tk::spline.
+template<int MaxPoints>
+class small_spline
+{
+public:
+	// the boundary conditions of tk::spline, with its values
+	enum bd_type
+	{
+		first_deriv = 1,
+		second_deriv = 2
+	};
+
+	small_spline()
+		: m_n(0), m_left(second_deriv), m_right(second_deriv), m_left_value(0.0),
+		  m_right_value(0.0), m_force_linear_extrapolation(false)
+	{
+	}
+
+	// optional, but if called it has to come before set_points()
+	void set_boundary(bd_type left, double left_value, bd_type right, double right_value,
+	                  bool force_linear_extrapolation = false)
+	{
+		assert(m_n == 0);
+		m_left = left;
+		m_right = right;
+		m_left_value = left_value;
+		m_right_value = right_value;
+		m_force_linear_extrapolation = force_linear_extrapolation;
+	}
+
+	// x strictly increasing, 3 <= n <= MaxPoints
+	void set_points(const double *x, const double *y, int n);
+	void set_points(const std::vector<double> &x, const std::vector<double> &y)
+	{
+		assert(x.size() == y.size());
+		set_points(&x[0], &y[0], (int)x.size());
+	}
+
+	double operator()(double x) const;
+
+	// Values at n x, the same as operator() for each of them, through
+	// eval_pieces(). The segments are walked with a cursor instead of
+	// searched, fastest for increasing x.
+	void eval_sorted(const double *x, int n, double *y, double *dy = 0, double *ddy = 0) const;
+
+	int size() const { return m_n; }
+
+private:
+	int m_n;
+	double m_x[MaxPoints];
+	double m_y[MaxPoints];
+	// f(x) = a*(x-x_i)^3 + b*(x-x_i)^2 + c*(x-x_i) + y_i
+	double m_a[MaxPoints];
+	double m_b[MaxPoints];
+	double m_c[MaxPoints];
+	double m_b0, m_c0; // left extrapolation
+	bd_type m_left, m_right;
+	double m_left_value, m_right_value;
+	bool m_force_linear_extrapolation;
+
+	// every piece as in operator(), left extrapolation first and right
+	// extrapolation last: y + h*(c + h*(b + h*a)) with h = x - origin
+	double m_piece_origin[MaxPoints + 1];
+	double m_piece_y[MaxPoints + 1];
+	double m_piece_a[MaxPoints + 1];
+	double m_piece_b[MaxPoints + 1];
+	double m_piece_c[MaxPoints + 1];
+
+	// workspace of the solve
+	double m_lower[MaxPoints];
+	double m_diag[MaxPoints];
+	double m_upper[MaxPoints];
+	double m_scale[MaxPoints];
+};
+
+template<int MaxPoints>
+void small_spline<MaxPoints>::set_points(const double *x, const double *y, int n)
+{
+	assert(n > 2 && n <= MaxPoints);
+	m_n = n;
+	std::copy(x, x + n, m_x);
+	std::copy(y, y + n, m_y);
+	for (int i = 0; i < n - 1; i++)
+	{
+		assert(m_x[i] < m_x[i + 1]);
+	}
+
+	// system for the b[], in the rows of tk::spline
+	double *rhs = m_b;
+	for (int i = 1; i < n - 1; i++)
+	{
+		m_lower[i] = 1.0 / 3.0 * (x[i] - x[i - 1]);
+		m_diag[i] = 2.0 / 3.0 * (x[i + 1] - x[i - 1]);
+		m_upper[i] = 1.0 / 3.0 * (x[i + 1] - x[i]);
+		rhs[i] = (y[i + 1] - y[i]) / (x[i + 1] - x[i]) - (y[i] - y[i - 1]) / (x[i] - x[i - 1]);
+	}
+	if (m_left == second_deriv)
+	{
+		m_diag[0] = 2.0;
+		m_upper[0] = 0.0;
+		rhs[0] = m_left_value;
+	}
+	else
+	{
+		m_diag[0] = 2.0 * (x[1] - x[0]);
+		m_upper[0] = 1.0 * (x[1] - x[0]);
+		rhs[0] = 3.0 * ((y[1] - y[0]) / (x[1] - x[0]) - m_left_value);
+	}
+	if (m_right == second_deriv)
+	{
+		m_diag[n - 1] = 2.0;
+		m_lower[n - 1] = 0.0;
+		rhs[n - 1] = m_right_value;
+	}
+	else
+	{
+		m_diag[n - 1] = 2.0 * (x[n - 1] - x[n - 2]);
+		m_lower[n - 1] = 1.0 * (x[n - 1] - x[n - 2]);
+		rhs[n - 1] = 3.0 * (m_right_value - (y[n - 1] - y[n - 2]) / (x[n - 1] - x[n - 2]));
+	}
+	thomas_solve(m_lower, m_diag, m_upper, m_scale, rhs, n);
+
+	for (int i = 0; i < n - 1; i++)
+	{
+		m_a[i] = 1.0 / 3.0 * (m_b[i + 1] - m_b[i]) / (x[i + 1] - x[i]);
+		m_c[i] = (y[i + 1] - y[i]) / (x[i + 1] - x[i]) - 1.0 / 3.0 * (2.0 * m_b[i] + m_b[i + 1]) * (x[i + 1] - x[i]);
+	}
+
+	m_b0 = (m_force_linear_extrapolation == false) ? m_b[0] : 0.0;
+	m_c0 = m_c[0];
+
+	double h = x[n - 1] - x[n - 2];
+	m_a[n - 1] = 0.0;
+	m_c[n - 1] = 3.0 * m_a[n - 2] * h * h + 2.0 * m_b[n - 2] * h + m_c[n - 2];
+	if (m_force_linear_extrapolation == true)
+	{
+		m_b[n - 1] = 0.0;
+	}
+
+	// the extrapolations as pieces with a == 0, which leaves the results unchanged
+	m_piece_origin[0] = m_x[0];
+	m_piece_y[0] = m_y[0];
+	m_piece_a[0] = 0.0;
+	m_piece_b[0] = m_b0;
+	m_piece_c[0] = m_c0;
+	for (int i = 0; i < n; i++)
+	{
+		m_piece_origin[i + 1] = m_x[i];
+		m_piece_y[i + 1] = m_y[i];
+		m_piece_a[i + 1] = m_a[i];
+		m_piece_b[i + 1] = m_b[i];
+		m_piece_c[i + 1] = m_c[i];
+	}
+}
+
+template<int MaxPoints>
+double small_spline<MaxPoints>::operator()(double x) const
+{
+	int n = m_n;
+	// closest point m_x[idx] < x, idx=0 even if x<m_x[0]
+	int idx = std::max(int(std::lower_bound(m_x, m_x + n, x) - m_x) - 1, 0);
+
+	double h = x - m_x[idx];
+	if (x < m_x[0])
+	{
+		return (m_b0 * h + m_c0) * h + m_y[0];
+	}
+	if (x > m_x[n - 1])
+	{
+		return (m_b[n - 1] * h + m_c[n - 1]) * h + m_y[n - 1];
+	}
+	return ((m_a[idx] * h + m_b[idx]) * h + m_c[idx]) * h + m_y[idx];
+}
+
+template<int MaxPoints>
+void small_spline<MaxPoints>::eval_sorted(const double *x, int n, double *y, double *dy, double *ddy) const
+{
+	spline_pieces pieces = { m_x, m_n, m_piece_origin, m_piece_y, m_piece_a, m_piece_b, m_piece_c };
+	eval_pieces(pieces, x, n, y, dy, ddy);
+}
+
+} // namespace tk
+
+} // namespace
+
+#endif /* TK_SMALL_SPLINE_H */
@@ -0,0 +1,193 @@
+/*
+ * spline_pieces.h
+ *
+ * The parts small_spline and fixed_spline share: the tridiagonal solve for
+ * the second order coefficients and the evaluation of a spline stored as
+ * pieces. Only plain arrays, so neither depends on tk::spline.
+ *
+ * Both follow tk::spline operation for operation, which keeps their results
+ * bit for bit those of tk::spline.
+ */
+
+#ifndef TK_SPLINE_PIECES_H
+#define TK_SPLINE_PIECES_H
+
+#include <cassert>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// same unnamed namespace as spline.h, so tk:: names both
+namespace
+{
+
+namespace tk
+{
+
+// Solves the tridiagonal system with sub diagonal lower[1..n-1], diagonal
+// diag and super diagonal upper[0..n-2] in place: the three bands are
+// overwritten by their LU factors, scale needs room for n values and rhs is
+// replaced by the solution. lower[0] and upper[n-1] are not used.
+inline void thomas_solve(double *lower, double *diag, double *upper, double *scale, double *rhs, int n)
+{
+	// normalize every row so its diagonal is 1
+	for (int i = 0; i < n; i++)
+	{
+		assert(diag[i] != 0.0);
+		scale[i] = 1.0 / diag[i];
+		if (i > 0)
+		{
+			lower[i] *= scale[i];
+		}
+		if (i < n - 1)
+		{
+			upper[i] *= scale[i];
+		}
+		diag[i] = 1.0;
+	}
+
+	// elimination, the multipliers replace the sub diagonal
+	for (int k = 0; k < n - 1; k++)
+	{
+		assert(diag[k] != 0.0);
+		double x = -lower[k + 1] / diag[k];
+		lower[k + 1] = -x;
+		diag[k + 1] = diag[k + 1] + x * upper[k];
+	}
+
+	// forward then backward substitution, the sums start at 0 like the
+	// band solver's so even the sign of a zero result is the same
+	for (int i = 0; i < n; i++)
+	{
+		double sum = 0;
+		if (i > 0)
+		{
+			sum += lower[i] * rhs[i - 1];
+		}
+		rhs[i] = (rhs[i] * scale[i]) - sum;
+	}
+	for (int i = n - 1; i >= 0; i--)
+	{
+		double sum = 0;
+		if (i < n - 1)
+		{
+			sum += upper[i] * rhs[i + 1];
+		}
+		rhs[i] = (rhs[i] - sum) / diag[i];
+	}
+}
+
+// The pieces of a cubic spline through n knots as tk::spline evaluates it:
+// left extrapolation, the n - 1 segments, right extrapolation. Piece k is
+// y[k] + h*(c[k] + h*(b[k] + h*a[k])) with h = x - origin[k].
+struct spline_pieces
+{
+	const double *knots;
+	int n;
+	const double *origin;
+	const double *y;
+	const double *a;
+	const double *b;
+	const double *c;
+};
+
+// piece of x from the cursor segment, which also goes back so unsorted x
+// are only slower
+inline int find_piece(const spline_pieces &p, double x, int &segment)
+{
+	while (segment + 2 < p.n && p.knots[segment + 1] < x)
+	{
+		segment++;
+	}
+	while (segment > 0 && !(p.knots[segment] < x))
+	{
+		segment--;
+	}
+	return x < p.knots[0] ? 0 : (x > p.knots[p.n - 1] ? p.n : segment + 1);
+}
+
+// whether find_piece() of x is k, without a cursor
+inline bool in_piece(const spline_pieces &p, double x, int k)
+{
+	if (k == 0)
+	{
+		return x < p.knots[0];
+	}
+	if (k == p.n)
+	{
+		return x > p.knots[p.n - 1];
+	}
+	return (k == 1 ? x >= p.knots[0] : x > p.knots[k - 1]) && x <= p.knots[k];
+}
+
+// values at count x, and the first and second derivatives where dy and ddy
+// are not NULL. Each run of x within one piece is evaluated with its
+// coefficients loaded once, four at a time with AVX2.
+inline void eval_pieces(const spline_pieces &p, const double *x, int count, double *y, double *dy, double *ddy)
+{
+	int segment = 0;
+	int i = 0;
+	while (i < count)
+	{
+		// the run of x in one piece shares its coefficients
+		int k = find_piece(p, x[i], segment);
+		int end = i + 1;
+		while (end < count && in_piece(p, x[end], k))
+		{
+			end++;
+		}
+		double origin = p.origin[k];
+		double a = p.a[k];
+		double b = p.b[k];
+		double c = p.c[k];
+		double y0 = p.y[k];
+
+#ifdef __AVX2__
+		// ((a*h + b)*h + c)*h + y, no fused multiply-add so operator() agrees
+		const __m256d va = _mm256_set1_pd(a);
+		const __m256d vb = _mm256_set1_pd(b);
+		const __m256d vc = _mm256_set1_pd(c);
+		const __m256d vy = _mm256_set1_pd(y0);
+		const __m256d vo = _mm256_set1_pd(origin);
+		const __m256d a3 = _mm256_set1_pd(3.0 * a);
+		const __m256d a6 = _mm256_set1_pd(6.0 * a);
+		const __m256d b2 = _mm256_set1_pd(2.0 * b);
+		for (; i + 4 <= end; i += 4)
+		{
+			__m256d h = _mm256_sub_pd(_mm256_loadu_pd(x + i), vo);
+			__m256d v = _mm256_add_pd(_mm256_mul_pd(va, h), vb);
+			v = _mm256_add_pd(_mm256_mul_pd(v, h), vc);
+			v = _mm256_add_pd(_mm256_mul_pd(v, h), vy);
+			_mm256_storeu_pd(y + i, v);
+			if (dy)
+			{
+				__m256d d = _mm256_add_pd(_mm256_mul_pd(a3, h), b2);
+				_mm256_storeu_pd(dy + i, _mm256_add_pd(_mm256_mul_pd(d, h), vc));
+			}
+			if (ddy)
+			{
+				_mm256_storeu_pd(ddy + i, _mm256_add_pd(_mm256_mul_pd(a6, h), b2));
+			}
+		}
+#endif
+		for (; i < end; i++)
+		{
+			double h = x[i] - origin;
+			y[i] = ((a * h + b) * h + c) * h + y0;
+			if (dy)
+			{
+				dy[i] = (3.0 * a * h + 2.0 * b) * h + c;
+			}
+			if (ddy)
+			{
+				ddy[i] = 6.0 * a * h + 2.0 * b;
+			}
+		}
+	}
+}
+
+} // namespace tk
+
+} // namespace
+
+#endif /* TK_SPLINE_PIECES_H */
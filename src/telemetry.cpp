@@ -0,0 +1,699 @@
+#include "telemetry.h"
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+namespace
+{
+
+// read position inside the frame, never moves past end
+struct Reader
+{
+	const char *p;
+	const char *end;
+};
+
+const double pow10_table[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// 5^q for q in [-64, 64], normalized to 128 bits with the top bit set:
+// truncated for q >= 0, rounded up for q < 0 (the reciprocal is inexact)
+const int pow5_smallest = -64;
+const int pow5_largest = 64;
+const uint64_t pow5_128[][2] = {
+	{ 0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL }, // 5^-64
+	{ 0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL }, // 5^-63
+	{ 0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL }, // 5^-62
+	{ 0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL }, // 5^-61
+	{ 0xcdb02555653131b6ULL, 0x3792f412cb06794dULL }, // 5^-60
+	{ 0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL }, // 5^-59
+	{ 0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL }, // 5^-58
+	{ 0xc8de047564d20a8bULL, 0xf245825a5a445275ULL }, // 5^-57
+	{ 0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL }, // 5^-56
+	{ 0x9ced737bb6c4183dULL, 0x55464dd69685606bULL }, // 5^-55
+	{ 0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL }, // 5^-54
+	{ 0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL }, // 5^-53
+	{ 0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL }, // 5^-52
+	{ 0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL }, // 5^-51
+	{ 0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL }, // 5^-50
+	{ 0x95a8637627989aadULL, 0xdde7001379a44aa8ULL }, // 5^-49
+	{ 0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL }, // 5^-48
+	{ 0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL }, // 5^-47
+	{ 0x9226712162ab070dULL, 0xcab3961304ca70e8ULL }, // 5^-46
+	{ 0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL }, // 5^-45
+	{ 0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL }, // 5^-44
+	{ 0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL }, // 5^-43
+	{ 0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL }, // 5^-42
+	{ 0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL }, // 5^-41
+	{ 0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL }, // 5^-40
+	{ 0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL }, // 5^-39
+	{ 0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL }, // 5^-38
+	{ 0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL }, // 5^-37
+	{ 0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL }, // 5^-36
+	{ 0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL }, // 5^-35
+	{ 0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL }, // 5^-34
+	{ 0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL }, // 5^-33
+	{ 0xcfb11ead453994baULL, 0x67de18eda5814af2ULL }, // 5^-32
+	{ 0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL }, // 5^-31
+	{ 0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL }, // 5^-30
+	{ 0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL }, // 5^-29
+	{ 0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL }, // 5^-28
+	{ 0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL }, // 5^-27
+	{ 0xc612062576589ddaULL, 0x95364afe032a819eULL }, // 5^-26
+	{ 0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL }, // 5^-25
+	{ 0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL }, // 5^-24
+	{ 0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL }, // 5^-23
+	{ 0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL }, // 5^-22
+	{ 0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL }, // 5^-21
+	{ 0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL }, // 5^-20
+	{ 0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL }, // 5^-19
+	{ 0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL }, // 5^-18
+	{ 0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL }, // 5^-17
+	{ 0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL }, // 5^-16
+	{ 0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL }, // 5^-15
+	{ 0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL }, // 5^-14
+	{ 0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL }, // 5^-13
+	{ 0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL }, // 5^-12
+	{ 0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL }, // 5^-11
+	{ 0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL }, // 5^-10
+	{ 0x89705f4136b4a597ULL, 0x31680a88f8953031ULL }, // 5^-9
+	{ 0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL }, // 5^-8
+	{ 0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL }, // 5^-7
+	{ 0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL }, // 5^-6
+	{ 0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL }, // 5^-5
+	{ 0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL }, // 5^-4
+	{ 0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL }, // 5^-3
+	{ 0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL }, // 5^-2
+	{ 0xccccccccccccccccULL, 0xcccccccccccccccdULL }, // 5^-1
+	{ 0x8000000000000000ULL, 0x0000000000000000ULL }, // 5^0
+	{ 0xa000000000000000ULL, 0x0000000000000000ULL }, // 5^1
+	{ 0xc800000000000000ULL, 0x0000000000000000ULL }, // 5^2
+	{ 0xfa00000000000000ULL, 0x0000000000000000ULL }, // 5^3
+	{ 0x9c40000000000000ULL, 0x0000000000000000ULL }, // 5^4
+	{ 0xc350000000000000ULL, 0x0000000000000000ULL }, // 5^5
+	{ 0xf424000000000000ULL, 0x0000000000000000ULL }, // 5^6
+	{ 0x9896800000000000ULL, 0x0000000000000000ULL }, // 5^7
+	{ 0xbebc200000000000ULL, 0x0000000000000000ULL }, // 5^8
+	{ 0xee6b280000000000ULL, 0x0000000000000000ULL }, // 5^9
+	{ 0x9502f90000000000ULL, 0x0000000000000000ULL }, // 5^10
+	{ 0xba43b74000000000ULL, 0x0000000000000000ULL }, // 5^11
+	{ 0xe8d4a51000000000ULL, 0x0000000000000000ULL }, // 5^12
+	{ 0x9184e72a00000000ULL, 0x0000000000000000ULL }, // 5^13
+	{ 0xb5e620f480000000ULL, 0x0000000000000000ULL }, // 5^14
+	{ 0xe35fa931a0000000ULL, 0x0000000000000000ULL }, // 5^15
+	{ 0x8e1bc9bf04000000ULL, 0x0000000000000000ULL }, // 5^16
+	{ 0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL }, // 5^17
+	{ 0xde0b6b3a76400000ULL, 0x0000000000000000ULL }, // 5^18
+	{ 0x8ac7230489e80000ULL, 0x0000000000000000ULL }, // 5^19
+	{ 0xad78ebc5ac620000ULL, 0x0000000000000000ULL }, // 5^20
+	{ 0xd8d726b7177a8000ULL, 0x0000000000000000ULL }, // 5^21
+	{ 0x878678326eac9000ULL, 0x0000000000000000ULL }, // 5^22
+	{ 0xa968163f0a57b400ULL, 0x0000000000000000ULL }, // 5^23
+	{ 0xd3c21bcecceda100ULL, 0x0000000000000000ULL }, // 5^24
+	{ 0x84595161401484a0ULL, 0x0000000000000000ULL }, // 5^25
+	{ 0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL }, // 5^26
+	{ 0xcecb8f27f4200f3aULL, 0x0000000000000000ULL }, // 5^27
+	{ 0x813f3978f8940984ULL, 0x4000000000000000ULL }, // 5^28
+	{ 0xa18f07d736b90be5ULL, 0x5000000000000000ULL }, // 5^29
+	{ 0xc9f2c9cd04674edeULL, 0xa400000000000000ULL }, // 5^30
+	{ 0xfc6f7c4045812296ULL, 0x4d00000000000000ULL }, // 5^31
+	{ 0x9dc5ada82b70b59dULL, 0xf020000000000000ULL }, // 5^32
+	{ 0xc5371912364ce305ULL, 0x6c28000000000000ULL }, // 5^33
+	{ 0xf684df56c3e01bc6ULL, 0xc732000000000000ULL }, // 5^34
+	{ 0x9a130b963a6c115cULL, 0x3c7f400000000000ULL }, // 5^35
+	{ 0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL }, // 5^36
+	{ 0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL }, // 5^37
+	{ 0x96769950b50d88f4ULL, 0x1314448000000000ULL }, // 5^38
+	{ 0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL }, // 5^39
+	{ 0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL }, // 5^40
+	{ 0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL }, // 5^41
+	{ 0xb7abc627050305adULL, 0xf14a3d9e40000000ULL }, // 5^42
+	{ 0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL }, // 5^43
+	{ 0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL }, // 5^44
+	{ 0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL }, // 5^45
+	{ 0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL }, // 5^46
+	{ 0x8c213d9da502de45ULL, 0x4526f422cc340000ULL }, // 5^47
+	{ 0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL }, // 5^48
+	{ 0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL }, // 5^49
+	{ 0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL }, // 5^50
+	{ 0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL }, // 5^51
+	{ 0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL }, // 5^52
+	{ 0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL }, // 5^53
+	{ 0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL }, // 5^54
+	{ 0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL }, // 5^55
+	{ 0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL }, // 5^56
+	{ 0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL }, // 5^57
+	{ 0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL }, // 5^58
+	{ 0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL }, // 5^59
+	{ 0x9f4f2726179a2245ULL, 0x01d762422c946590ULL }, // 5^60
+	{ 0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL }, // 5^61
+	{ 0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL }, // 5^62
+	{ 0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL }, // 5^63
+	{ 0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL }, // 5^64
+};
+
+// high and low 64 bits of a*b
+void multiply_64(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 p = (unsigned __int128)a * b;
+	hi = (uint64_t)(p >> 64);
+	lo = (uint64_t)p;
+#else
+	uint64_t a_lo = a & 0xFFFFFFFFULL, a_hi = a >> 32;
+	uint64_t b_lo = b & 0xFFFFFFFFULL, b_hi = b >> 32;
+	uint64_t ll = a_lo * b_lo;
+	uint64_t lh = a_lo * b_hi;
+	uint64_t hl = a_hi * b_lo;
+	uint64_t hh = a_hi * b_hi;
+	uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFULL) + (hl & 0xFFFFFFFFULL);
+	lo = (mid << 32) | (ll & 0xFFFFFFFFULL);
+	hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+int leading_zeros(uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_clzll(x);
+#else
+	int n = 0;
+	while (!(x & (1ULL << 63)))
+	{
+		x <<= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+// Eisel-Lemire: the correctly rounded double nearest to mantissa * 10^exp10
+// from the top 128 bits of the product with 5^exp10. Returns false when the
+// power is outside the table or the truncated product cannot decide the
+// rounding, then only strtod gets it right.
+bool eisel_lemire(uint64_t mantissa, int exp10, bool negative, double &value)
+{
+	if (mantissa == 0)
+	{
+		value = negative ? -0.0 : 0.0;
+		return true;
+	}
+	if (exp10 < pow5_smallest || exp10 > pow5_largest)
+	{
+		return false;
+	}
+	const uint64_t *power = pow5_128[exp10 - pow5_smallest];
+
+	int lz = leading_zeros(mantissa);
+	uint64_t w = mantissa << lz;
+	uint64_t upper, lower;
+	multiply_64(w, power[0], upper, lower);
+
+	// the low word of the power can still carry into the bits that round
+	if ((upper & 0x1FF) == 0x1FF && lower + w < lower)
+	{
+		uint64_t cross, low;
+		multiply_64(w, power[1], cross, low);
+		uint64_t middle = lower + cross;
+		if (middle < lower)
+		{
+			upper++;
+		}
+		if (middle + 1 == 0 && (upper & 0x1FF) == 0x1FF && low + w < low)
+		{
+			return false;
+		}
+		lower = middle;
+	}
+
+	uint64_t upper_bit = upper >> 63;
+	uint64_t bits = upper >> (upper_bit + 9);
+	lz += (int)(1 ^ upper_bit);
+
+	// exactly halfway between two doubles, the truncation hides which way to round
+	if (lower == 0 && (upper & 0x1FF) == 0 && (bits & 3) == 1)
+	{
+		return false;
+	}
+
+	bits += bits & 1;
+	bits >>= 1;
+	if (bits >= (1ULL << 53))
+	{
+		bits = 1ULL << 52;
+		lz--;
+	}
+	bits &= ~(1ULL << 52);
+
+	// floor(log2(10^exp10)) + 63 + the double exponent bias
+	int64_t exponent = (((152170 + 65536) * (int64_t)exp10) >> 16) + 1024 + 63 - lz;
+	if (exponent < 1 || exponent > 2046)
+	{
+		return false;
+	}
+	bits |= (uint64_t)exponent << 52;
+	bits |= (uint64_t)negative << 63;
+	memcpy(&value, &bits, sizeof(value));
+	return true;
+}
+
+void skip_ws(Reader &r)
+{
+	while (r.p < r.end && (*r.p == ' ' || *r.p == '\t' || *r.p == '\n' || *r.p == '\r'))
+	{
+		r.p++;
+	}
+}
+
+bool consume(Reader &r, char c)
+{
+	skip_ws(r);
+	if (r.p < r.end && *r.p == c)
+	{
+		r.p++;
+		return true;
+	}
+	return false;
+}
+
+bool consume_literal(Reader &r, const char *literal)
+{
+	skip_ws(r);
+	size_t n = strlen(literal);
+	if ((size_t)(r.end - r.p) >= n && memcmp(r.p, literal, n) == 0)
+	{
+		r.p += n;
+		return true;
+	}
+	return false;
+}
+
+// points key at the characters between the quotes, escapes are skipped but not decoded
+bool read_string(Reader &r, const char *&str, size_t &len)
+{
+	if (!consume(r, '"'))
+	{
+		return false;
+	}
+	str = r.p;
+	while (r.p < r.end && *r.p != '"')
+	{
+		if (*r.p == '\\')
+		{
+			r.p++;
+		}
+		r.p++;
+	}
+	if (r.p >= r.end)
+	{
+		return false;
+	}
+	len = r.p - str;
+	r.p++;
+	return true;
+}
+
+bool read_number(Reader &r, double &value)
+{
+	skip_ws(r);
+	const char *start = r.p;
+
+	bool negative = false;
+	if (r.p < r.end && (*r.p == '-' || *r.p == '+'))
+	{
+		negative = (*r.p == '-');
+		r.p++;
+	}
+
+	// up to 19 significant digits fit in the mantissa, the rest only shift the exponent
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exp10 = 0;
+	bool any_digit = false;
+	bool truncated = false;
+	while (r.p < r.end && *r.p >= '0' && *r.p <= '9')
+	{
+		any_digit = true;
+		if (digits < 19)
+		{
+			mantissa = mantissa*10 + (*r.p - '0');
+			digits += (mantissa != 0);
+		}
+		else
+		{
+			truncated |= (*r.p != '0');
+			exp10++;
+		}
+		r.p++;
+	}
+	if (r.p < r.end && *r.p == '.')
+	{
+		r.p++;
+		while (r.p < r.end && *r.p >= '0' && *r.p <= '9')
+		{
+			any_digit = true;
+			if (digits < 19)
+			{
+				mantissa = mantissa*10 + (*r.p - '0');
+				digits += (mantissa != 0);
+				exp10--;
+			}
+			else
+			{
+				truncated |= (*r.p != '0');
+			}
+			r.p++;
+		}
+	}
+	if (!any_digit)
+	{
+		return false;
+	}
+	if (r.p < r.end && (*r.p == 'e' || *r.p == 'E'))
+	{
+		r.p++;
+		bool exp_negative = false;
+		if (r.p < r.end && (*r.p == '-' || *r.p == '+'))
+		{
+			exp_negative = (*r.p == '-');
+			r.p++;
+		}
+		int e = 0;
+		while (r.p < r.end && *r.p >= '0' && *r.p <= '9')
+		{
+			if (e < 10000)
+			{
+				e = e*10 + (*r.p - '0');
+			}
+			r.p++;
+		}
+		exp10 += exp_negative ? -e : e;
+	}
+
+	// exact when both the mantissa and the power of ten are representable
+	if (mantissa < (1ULL << 53) && exp10 >= -22 && exp10 <= 22)
+	{
+		double v = (double)mantissa;
+		v = exp10 < 0 ? v / pow10_table[-exp10] : v * pow10_table[exp10];
+		value = negative ? -v : v;
+		return true;
+	}
+
+	// the 16 and 17 digit literals the simulator sends, exact in 128 bits
+	if (!truncated && eisel_lemire(mantissa, exp10, negative, value))
+	{
+		return true;
+	}
+
+	// rare long, extreme or halfway literals go through strtod on a stack copy
+	char buf[64];
+	size_t n = r.p - start;
+	if (n >= sizeof(buf))
+	{
+		return false;
+	}
+	memcpy(buf, start, n);
+	buf[n] = '\0';
+	value = strtod(buf, NULL);
+	return true;
+}
+
+bool skip_value(Reader &r)
+{
+	skip_ws(r);
+	if (r.p >= r.end)
+	{
+		return false;
+	}
+
+	const char *str;
+	size_t len;
+	double number;
+	switch (*r.p)
+	{
+	case '"':
+		return read_string(r, str, len);
+	case '[':
+	case '{':
+		{
+			char close = (*r.p == '[') ? ']' : '}';
+			r.p++;
+			if (consume(r, close))
+			{
+				return true;
+			}
+			do
+			{
+				if (close == '}' && !(read_string(r, str, len) && consume(r, ':')))
+				{
+					return false;
+				}
+				if (!skip_value(r))
+				{
+					return false;
+				}
+			} while (consume(r, ','));
+			return consume(r, close);
+		}
+	case 't':
+		return consume_literal(r, "true");
+	case 'f':
+		return consume_literal(r, "false");
+	case 'n':
+		return consume_literal(r, "null");
+	default:
+		return read_number(r, number);
+	}
+}
+
+bool read_array(Reader &r, double *values, int capacity, int &count)
+{
+	count = 0;
+	if (!consume(r, '['))
+	{
+		return false;
+	}
+	if (consume(r, ']'))
+	{
+		return true;
+	}
+	do
+	{
+		if (count == capacity || !read_number(r, values[count]))
+		{
+			return false;
+		}
+		count++;
+	} while (consume(r, ','));
+	return consume(r, ']');
+}
+
+bool read_sensor_fusion(Reader &r, SensorFusion &cars)
+{
+	int &count = cars.size;
+	count = 0;
+	if (!consume(r, '['))
+	{
+		return false;
+	}
+	if (consume(r, ']'))
+	{
+		return true;
+	}
+	do
+	{
+		// each row is [id, x, y, vx, vy, s, d], scattered into the columns
+		double row[7];
+		int n;
+		if (count == SensorFusion::MAX_CARS || !read_array(r, row, 7, n) || n != 7)
+		{
+			return false;
+		}
+		cars.id[count] = row[0];
+		cars.x[count] = row[1];
+		cars.y[count] = row[2];
+		cars.vx[count] = row[3];
+		cars.vy[count] = row[4];
+		cars.s[count] = row[5];
+		cars.d[count] = row[6];
+		count++;
+	} while (consume(r, ','));
+	return consume(r, ']');
+}
+
+bool key_is(const char *key, size_t len, const char *name)
+{
+	return strlen(name) == len && memcmp(key, name, len) == 0;
+}
+
+enum
+{
+	HAS_X = 1 << 0,
+	HAS_Y = 1 << 1,
+	HAS_S = 1 << 2,
+	HAS_D = 1 << 3,
+	HAS_YAW = 1 << 4,
+	HAS_SPEED = 1 << 5,
+	HAS_PREVIOUS_X = 1 << 6,
+	HAS_PREVIOUS_Y = 1 << 7,
+	HAS_END_S = 1 << 8,
+	HAS_END_D = 1 << 9,
+	HAS_SENSOR_FUSION = 1 << 10,
+	HAS_ALL = (1 << 11) - 1
+};
+
+bool read_telemetry_object(Reader &r, Telemetry &out)
+{
+	if (!consume(r, '{'))
+	{
+		return false;
+	}
+
+	int found = 0;
+	int previous_y_size = 0;
+	if (!consume(r, '}'))
+	{
+		do
+		{
+			const char *key;
+			size_t len;
+			if (!read_string(r, key, len) || !consume(r, ':'))
+			{
+				return false;
+			}
+
+			bool ok;
+			if (key_is(key, len, "x")) { ok = read_number(r, out.x); found |= HAS_X; }
+			else if (key_is(key, len, "y")) { ok = read_number(r, out.y); found |= HAS_Y; }
+			else if (key_is(key, len, "s")) { ok = read_number(r, out.s); found |= HAS_S; }
+			else if (key_is(key, len, "d")) { ok = read_number(r, out.d); found |= HAS_D; }
+			else if (key_is(key, len, "yaw")) { ok = read_number(r, out.yaw); found |= HAS_YAW; }
+			else if (key_is(key, len, "speed")) { ok = read_number(r, out.speed); found |= HAS_SPEED; }
+			else if (key_is(key, len, "previous_path_x"))
+			{
+				ok = read_array(r, out.previous_path_x, Telemetry::MAX_PATH, out.previous_path_size);
+				found |= HAS_PREVIOUS_X;
+			}
+			else if (key_is(key, len, "previous_path_y"))
+			{
+				ok = read_array(r, out.previous_path_y, Telemetry::MAX_PATH, previous_y_size);
+				found |= HAS_PREVIOUS_Y;
+			}
+			else if (key_is(key, len, "end_path_s")) { ok = read_number(r, out.end_path_s); found |= HAS_END_S; }
+			else if (key_is(key, len, "end_path_d")) { ok = read_number(r, out.end_path_d); found |= HAS_END_D; }
+			else if (key_is(key, len, "sensor_fusion"))
+			{
+				ok = read_sensor_fusion(r, out.sensor_fusion);
+				found |= HAS_SENSOR_FUSION;
+			}
+			else
+			{
+				ok = skip_value(r);
+			}
+
+			if (!ok)
+			{
+				return false;
+			}
+		} while (consume(r, ','));
+
+		if (!consume(r, '}'))
+		{
+			return false;
+		}
+	}
+
+	return found == HAS_ALL && previous_y_size == out.previous_path_size;
+}
+
+}
+
+TelemetryStatus parse_telemetry(const char *data, size_t length, Telemetry &out)
+{
+	// "42" at the start of the message means there's a websocket message event.
+	if (length <= 2 || data[0] != '4' || data[1] != '2')
+	{
+		return TELEMETRY_IGNORED;
+	}
+
+	Reader r = { data + 2, data + length };
+
+	const char *event;
+	size_t event_len;
+	if (!consume(r, '['))
+	{
+		return TELEMETRY_MANUAL;
+	}
+	if (!read_string(r, event, event_len) || !consume(r, ','))
+	{
+		return TELEMETRY_ERROR;
+	}
+	if (consume_literal(r, "null"))
+	{
+		return TELEMETRY_MANUAL;
+	}
+	if (!key_is(event, event_len, "telemetry"))
+	{
+		return TELEMETRY_IGNORED;
+	}
+
+	if (!read_telemetry_object(r, out) || !consume(r, ']'))
+	{
+		return TELEMETRY_ERROR;
+	}
+	return TELEMETRY_OK;
+}
+
+bool parse_control(const char *data, size_t length, double *next_x, double *next_y, int capacity, int &count)
+{
+	count = 0;
+	if (length <= 2 || data[0] != '4' || data[1] != '2')
+	{
+		return false;
+	}
+
+	Reader r = { data + 2, data + length };
+	const char *key;
+	size_t len;
+	if (!consume(r, '[') || !read_string(r, key, len) || !key_is(key, len, "control") ||
+		!consume(r, ',') || !consume(r, '{'))
+	{
+		return false;
+	}
+
+	int x_size = -1;
+	int y_size = -1;
+	do
+	{
+		if (!read_string(r, key, len) || !consume(r, ':'))
+		{
+			return false;
+		}
+		bool ok;
+		if (key_is(key, len, "next_x"))
+		{
+			ok = read_array(r, next_x, capacity, x_size);
+		}
+		else if (key_is(key, len, "next_y"))
+		{
+			ok = read_array(r, next_y, capacity, y_size);
+		}
+		else
+		{
+			ok = skip_value(r);
+		}
+		if (!ok)
+		{
+			return false;
+		}
+	} while (consume(r, ','));
+
+	if (!consume(r, '}') || !consume(r, ']') || x_size < 0 || x_size != y_size)
+	{
+		return false;
+	}
+	count = x_size;
+	return true;
+}
@@ -0,0 +1,51 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <cstddef>
+#include "sensor_fusion.h"
+
+// Fixed layout of a telemetry message. It is allocated once and refilled
+// in place for every message, so decoding never touches the heap.
+struct Telemetry
+{
+	static const int MAX_PATH = 256;
+
+	// Main car's localization Data
+	double x;
+	double y;
+	double s;
+	double d;
+	double yaw;   // degrees
+	double speed; // mph
+
+	// Previous path data given to the Planner
+	int previous_path_size;
+	double previous_path_x[MAX_PATH];
+	double previous_path_y[MAX_PATH];
+
+	// Previous path's end s and d values
+	double end_path_s;
+	double end_path_d;
+
+	// Sensor Fusion Data, a list of all other cars on the same side of the road.
+	SensorFusion sensor_fusion;
+};
+
+enum TelemetryStatus
+{
+	TELEMETRY_OK,      // out holds the decoded message
+	TELEMETRY_MANUAL,  // socket.io event without data, the simulator is in manual mode
+	TELEMETRY_IGNORED, // not a "42" event or not a telemetry event
+	TELEMETRY_ERROR    // malformed message or more points/cars than fit in Telemetry
+};
+
+// Decodes a raw '42["telemetry",{...}]' websocket frame straight from the
+// receive buffer. The buffer does not need to be null terminated.
+TelemetryStatus parse_telemetry(const char *data, size_t length, Telemetry &out);
+
+// Decodes a '42["control",{"next_x":[...],"next_y":[...]}]' reply, the other
+// direction, for tools that stand in for the simulator. False if the frame is
+// malformed, the arrays differ in length or hold more than capacity points.
+bool parse_control(const char *data, size_t length, double *next_x, double *next_y, int capacity, int &count);
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,88 @@
+#include "telemetry_log.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+static const char log_magic[8] = { 'P', 'P', 'L', 'O', 'G', '0', '2', '\n' };
+static const char log_magic_v1[8] = { 'P', 'P', 'L', 'O', 'G', '0', '1', '\n' };
+
+static uint64_t now_ns()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void put_le(ofstream &out, uint64_t value, int bytes)
+{
+	char buf[8];
+	for (int i = 0; i < bytes; i++)
+	{
+		buf[i] = (char)(value >> (8 * i));
+	}
+	out.write(buf, bytes);
+}
+
+static bool get_le(ifstream &in, uint64_t &value, int bytes)
+{
+	unsigned char buf[8];
+	if (!in.read((char *)buf, bytes))
+	{
+		return false;
+	}
+	value = 0;
+	for (int i = 0; i < bytes; i++)
+	{
+		value |= (uint64_t)buf[i] << (8 * i);
+	}
+	return true;
+}
+
+bool TelemetryLogWriter::open(const string &path)
+{
+	out.open(path.c_str(), ofstream::out | ofstream::binary | ofstream::trunc);
+	if (!out.is_open())
+	{
+		return false;
+	}
+	out.write(log_magic, sizeof(log_magic));
+	start_ns = now_ns();
+	return true;
+}
+
+void TelemetryLogWriter::write(LogDirection direction, uint32_t connection, const char *data, size_t length)
+{
+	lock_guard<mutex> guard(lock);
+	put_le(out, (uint64_t)direction, 1);
+	put_le(out, connection, 4);
+	put_le(out, now_ns() - start_ns, 8);
+	put_le(out, (uint64_t)length, 4);
+	out.write(data, length);
+}
+
+bool TelemetryLogReader::open(const string &path)
+{
+	in.open(path.c_str(), ifstream::in | ifstream::binary);
+	char magic[sizeof(log_magic)];
+	if (!in.is_open() || !in.read(magic, sizeof(magic)))
+	{
+		return false;
+	}
+	numbered = equal(magic, magic + sizeof(magic), log_magic);
+	return numbered || equal(magic, magic + sizeof(magic), log_magic_v1);
+}
+
+bool TelemetryLogReader::next(LogRecord &record)
+{
+	uint64_t direction;
+	uint64_t connection = 0;
+	uint64_t length;
+	if (!get_le(in, direction, 1) || (numbered && !get_le(in, connection, 4)) ||
+		!get_le(in, record.timestamp_ns, 8) || !get_le(in, length, 4))
+	{
+		return false;
+	}
+	record.connection = (uint32_t)connection;
+	record.direction = direction == LOG_OUTBOUND ? LOG_OUTBOUND : LOG_INBOUND;
+	record.frame.resize(length);
+	return length == 0 || (bool)in.read(&record.frame[0], length);
+}
@@ -0,0 +1,70 @@
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#include <fstream>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Binary log of the raw websocket frames exchanged with the simulator.
+//
+// File layout: the 8 byte magic "PPLOG02\n", then one record per frame:
+//   uint8   direction (LOG_INBOUND or LOG_OUTBOUND)
+//   uint32  connection the frame belongs to
+//   uint64  nanoseconds since the log was opened
+//   uint32  frame length
+//   bytes   frame, exactly as received or sent
+// Integers are little endian. Logs from before connections were numbered,
+// "PPLOG01\n" without the connection field, read as all from connection 0.
+
+enum LogDirection
+{
+	LOG_INBOUND = 0,
+	LOG_OUTBOUND = 1
+};
+
+struct LogRecord
+{
+	LogDirection direction;
+	uint32_t connection;
+	uint64_t timestamp_ns;
+	std::vector<char> frame; // reused between reads
+};
+
+class TelemetryLogWriter
+{
+public:
+	TelemetryLogWriter() {}
+
+	bool open(const std::string &path);
+	bool is_open() const { return out.is_open(); }
+
+	// timestamps are taken from a steady clock relative to open().
+	// Safe to call from several event loop threads.
+	void write(LogDirection direction, uint32_t connection, const char *data, size_t length);
+
+private:
+	std::ofstream out;
+	uint64_t start_ns;
+	std::mutex lock;
+};
+
+class TelemetryLogReader
+{
+public:
+	TelemetryLogReader() : numbered(false) {}
+
+	// false if the file is missing or not a frame log
+	bool open(const std::string &path);
+
+	// false at the end of the log or on a truncated record
+	bool next(LogRecord &record);
+
+private:
+	std::ifstream in;
+	bool numbered; // the records carry a connection
+
+};
+
+#endif /* TELEMETRY_LOG_H */
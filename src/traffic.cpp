@@ -0,0 +1,88 @@
+#include "traffic.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+static bool gap_less(const TrafficSnapshot::Entry &a, const TrafficSnapshot::Entry &b)
+{
+	return a.gap < b.gap;
+}
+
+static bool entry_below(const TrafficSnapshot::Entry &a, double gap)
+{
+	return a.gap < gap;
+}
+
+static bool entry_above(double gap, const TrafficSnapshot::Entry &a)
+{
+	return gap < a.gap;
+}
+
+void TrafficSnapshot::build(const Prediction &traffic, double horizon, double ego_s, int num_lanes, double max_s)
+{
+	buckets.resize(num_lanes);
+	for (int k = 0; k < num_lanes; k++)
+	{
+		buckets[k].clear();
+	}
+
+	for (int i = 0; i < traffic.size(); i++)
+	{
+		const Track &t = traffic.track(i);
+
+		// a car just behind the start line is close behind a car just past it
+		Entry e;
+		e.gap = t.s + t.s_dot * horizon - ego_s;
+		e.gap -= max_s * floor(e.gap / max_s + 0.5);
+		e.car = i;
+		if (t.lane >= 0 && t.lane < num_lanes)
+		{
+			buckets[t.lane].push_back(e);
+		}
+		if (t.target != t.lane && t.target >= 0 && t.target < num_lanes)
+		{
+			buckets[t.target].push_back(e);
+		}
+	}
+
+	for (int k = 0; k < num_lanes; k++)
+	{
+		sort(buckets[k].begin(), buckets[k].end(), gap_less);
+	}
+}
+
+TrafficSnapshot::Range TrafficSnapshot::between(int lane, double lo, double hi) const
+{
+	if (lane < 0 || lane >= lanes() || buckets[lane].empty())
+	{
+		return Range(NULL, NULL);
+	}
+
+	const vector<Entry> &bucket = buckets[lane];
+	const Entry *first = &bucket[0] + (upper_bound(bucket.begin(), bucket.end(), lo, entry_above) - bucket.begin());
+	const Entry *last = &bucket[0] + (lower_bound(bucket.begin(), bucket.end(), hi, entry_below) - bucket.begin());
+	if (last < first)
+	{
+		last = first;
+	}
+	return Range(first, last);
+}
+
+int TrafficSnapshot::count_between(int lane, double lo, double hi) const
+{
+	Range r = between(lane, lo, hi);
+	return (int)(r.second - r.first);
+}
+
+const TrafficSnapshot::Entry *TrafficSnapshot::nearest_ahead(int lane) const
+{
+	Range r = between(lane, 0, HUGE_VAL);
+	return r.first != r.second ? r.first : NULL;
+}
+
+const TrafficSnapshot::Entry *TrafficSnapshot::nearest_behind(int lane) const
+{
+	Range r = between(lane, -HUGE_VAL, 0);
+	return r.first != r.second ? r.second - 1 : NULL;
+}
@@ -0,0 +1,44 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include <utility>
+#include <vector>
+#include "prediction.h"
+
+// Surrounding cars sorted into one bucket per lane, ordered by their gap to
+// the ego car. Built once per tick from the tracks of the prediction and
+// shared by every query of that tick.
+class TrafficSnapshot
+{
+public:
+	struct Entry
+	{
+		double gap; // wrapped into [-max_s/2, max_s/2), positive ahead
+		int car;    // index of the track in the Prediction
+	};
+	typedef std::pair<const Entry *, const Entry *> Range;
+
+	TrafficSnapshot() {}
+
+	// Gaps from ego_s to where each car is after horizon seconds at its
+	// speed along the road, wrapped around the track. A car changing lanes
+	// is in the lane it leaves and the one it moves to, cars outside lanes
+	// [0, num_lanes) are dropped.
+	void build(const Prediction &traffic, double horizon, double ego_s, int num_lanes, double max_s);
+
+	int lanes() const { return (int)buckets.size(); }
+
+	// cars with lo < gap < hi in the lane, closest to lo first
+	Range between(int lane, double lo, double hi) const;
+	int count_between(int lane, double lo, double hi) const;
+
+	// closest car strictly ahead of / behind the ego car, NULL if the lane is empty that way
+	const Entry *nearest_ahead(int lane) const;
+	const Entry *nearest_behind(int lane) const;
+
+private:
+	// vectors keep their capacity between ticks
+	std::vector< std::vector<Entry> > buckets;
+};
+
+#endif /* TRAFFIC_H */
@@ -0,0 +1,89 @@
+#include "trajectory_buffer.h"
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+using namespace std;
+
+namespace
+{
+
+const double unknown = numeric_limits<double>::quiet_NaN();
+
+// the simulator may send back the points with fewer digits than it got
+const double same_point = 1e-3;
+
+}
+
+TrajectoryBuffer::TrajectoryBuffer(int capacity)
+	: limit(capacity), head(0), count(0), xs(2 * capacity), ys(2 * capacity), vs(2 * capacity),
+	  as(2 * capacity), origin_v(0)
+{
+}
+
+void TrajectoryBuffer::clear()
+{
+	head = 0;
+	count = 0;
+}
+
+bool TrajectoryBuffer::sync(const Telemetry &j)
+{
+	int remaining = j.previous_path_size;
+	origin_v = j.speed / 2.24;
+
+	if (remaining <= count)
+	{
+		// the driven points are the first ones, what is left must line up
+		int first = head + count - remaining;
+		int last = head + count - 1;
+		bool same = remaining == 0 ||
+			(fabs(xs[first] - j.previous_path_x[0]) < same_point &&
+			 fabs(ys[first] - j.previous_path_y[0]) < same_point &&
+			 fabs(xs[last] - j.previous_path_x[remaining - 1]) < same_point &&
+			 fabs(ys[last] - j.previous_path_y[remaining - 1]) < same_point);
+		if (same)
+		{
+			head = first;
+			count = remaining;
+			return true;
+		}
+	}
+
+	clear();
+	for (int i = 0; i < remaining && i < limit; i++)
+	{
+		push(j.previous_path_x[i], j.previous_path_y[i], unknown, unknown);
+	}
+	return false;
+}
+
+void TrajectoryBuffer::extend(double x, double y, double v)
+{
+	double last_v = count > 0 ? vs[head + count - 1] : origin_v;
+	double a = isnan(last_v) ? 0 : (v - last_v) / .02;
+	push(x, y, v, a);
+}
+
+void TrajectoryBuffer::push(double x, double y, double v, double a)
+{
+	if (count == limit)
+	{
+		return;
+	}
+	if (head + count == 2 * limit)
+	{
+		// back to the front, the live points never overlap their new place
+		copy(xs.begin() + head, xs.begin() + head + count, xs.begin());
+		copy(ys.begin() + head, ys.begin() + head + count, ys.begin());
+		copy(vs.begin() + head, vs.begin() + head + count, vs.begin());
+		copy(as.begin() + head, as.begin() + head + count, as.begin());
+		head = 0;
+	}
+	int k = head + count;
+	xs[k] = x;
+	ys[k] = y;
+	vs[k] = v;
+	as[k] = a;
+	count++;
+}
@@ -0,0 +1,54 @@
+#ifndef TRAJECTORY_BUFFER_H
+#define TRAJECTORY_BUFFER_H
+
+#include <vector>
+#include "telemetry.h"
+
+// The points sent to the simulator and not driven yet, with the state the
+// planner gave each of them. Driven points are dropped at the head and new
+// ones appended at the tail, so a tick only touches the points it changes.
+//
+// The live points stay contiguous for the control message: the storage holds
+// twice the capacity and the live points are moved back to the front when
+// the tail reaches the end, at most once per capacity points driven.
+class TrajectoryBuffer
+{
+public:
+	explicit TrajectoryBuffer(int capacity = Telemetry::MAX_PATH);
+
+	void clear();
+
+	// Drops the points driven since the last tick so the buffer ends like the
+	// previous path of j, false when it does not. The previous path is then
+	// taken over with v and a unknown (NaN).
+	bool sync(const Telemetry &j);
+
+	// Appends a point. a follows from the change of v from the last point,
+	// or from the car's speed at the last sync() with an empty buffer, and
+	// is 0 where the last v is unknown.
+	void extend(double x, double y, double v);
+
+	int size() const { return count; }
+	int capacity() const { return limit; }
+
+	const double *x() const { return &xs[head]; }
+	const double *y() const { return &ys[head]; }
+	double v(int i) const { return vs[head + i]; }
+	double a(int i) const { return as[head + i]; }
+
+private:
+	int limit;
+	int head;
+	int count;
+	std::vector<double> xs;
+	std::vector<double> ys;
+	std::vector<double> vs;  // m/s
+	std::vector<double> as;  // m/s^2
+
+	// the car's speed at the last sync(), where an empty buffer continues from
+	double origin_v;
+
+	void push(double x, double y, double v, double a);
+};
+
+#endif /* TRAJECTORY_BUFFER_H */
@@ -0,0 +1,103 @@
+#include "velocity_profile.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+namespace
+{
+
+const double dt = 0.02;
+
+// speed difference to the target small enough to just keep the target
+const double holding = 1e-6;
+
+// following distance, standing and per m/s of the lead vehicle
+const double standing_gap = 10;
+const double time_gap = 1.0;
+
+// The acceleration for the next step that reaches target when it is ramped
+// back to 0 at max_jerk right after: the speed then changes by
+// a*dt + a*|a| / (2*max_jerk), solved for a.
+double landing_accel(double v, double target, double max_jerk)
+{
+	double change = target - v;
+	double a = max_jerk * (sqrt(dt * dt + 2 * fabs(change) / max_jerk) - dt);
+	return change < 0 ? -a : a;
+}
+
+}
+
+SpeedLimits default_speed_limits()
+{
+	SpeedLimits limits;
+	limits.max_speed = 49.5 / 2.24;
+	limits.max_accel = 7;
+	limits.max_decel = 7;
+	limits.max_jerk = 8;
+	return limits;
+}
+
+VelocityProfile::VelocityProfile(const SpeedLimits &limits) : bounds(limits)
+{
+}
+
+double VelocityProfile::follow_gap(double speed)
+{
+	return standing_gap + time_gap * speed;
+}
+
+double VelocityProfile::plan(double v, double a, double target, const LeadVehicle *lead, int n, double *speeds) const
+{
+	double step_jerk = bounds.max_jerk * dt;
+	double braking = bounds.max_decel / 2;
+	target = max(0.0, min(target, bounds.max_speed));
+	double travelled = 0;
+	for (int i = 0; i < n; i++)
+	{
+		double goal = target;
+		if (lead)
+		{
+			double time = (i + 1) * dt;
+			double room = lead->gap + lead->speed * time - travelled - follow_gap(lead->speed);
+			double safe = sqrt(lead->speed * lead->speed + 2 * braking * max(0.0, room));
+			// inside the following distance a little slower than the lead
+			goal = min(goal, room > 0 ? safe : max(0.0, lead->speed + room / time_gap));
+		}
+
+		// the speed reached is monotonic in a, the bounds only need the
+		// exact solution when it lies between them. Braking never goes past
+		// the a that lands on standing still, so stopping ramps a back to 0
+		// at max_jerk like reaching any other speed.
+		double lo = max(-bounds.max_decel, a - step_jerk);
+		double hi = min(bounds.max_accel, a + step_jerk);
+		lo = max(lo, min(hi, landing_accel(v, 0, bounds.max_jerk)));
+		if (fabs(goal - v) < holding && fabs(a) <= step_jerk)
+		{
+			a = 0;
+			v = goal;
+		}
+		else if (v + hi * dt + hi * fabs(hi) / (2 * bounds.max_jerk) <= goal)
+		{
+			a = hi;
+		}
+		else if (v + lo * dt + lo * fabs(lo) / (2 * bounds.max_jerk) >= goal)
+		{
+			a = lo;
+		}
+		else
+		{
+			a = max(lo, min(hi, landing_accel(v, goal, bounds.max_jerk)));
+		}
+		v += a * dt;
+		if (v < 0)
+		{
+			// only from a state braking too hard to stop in time, a keeps
+			// ramping back instead of jumping to 0
+			v = 0;
+		}
+		speeds[i] = v;
+		travelled += v * dt;
+	}
+	return a;
+}
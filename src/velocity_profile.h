@@ -0,0 +1,53 @@
+#ifndef VELOCITY_PROFILE_H
+#define VELOCITY_PROFILE_H
+
+// Bounds on the speed along the path and on its first two derivatives. The
+// simulator limits the total acceleration and jerk, so these leave room for
+// the lateral part of curves and lane changes.
+struct SpeedLimits
+{
+	double max_speed;  // m/s
+	double max_accel;  // m/s^2 speeding up
+	double max_decel;  // m/s^2 slowing down, positive
+	double max_jerk;   // m/s^3
+};
+
+// just below the 50 mph speed limit, well inside 10 m/s^2 and 10 m/s^3
+SpeedLimits default_speed_limits();
+
+// A car ahead on the path, assumed to keep its speed.
+struct LeadVehicle
+{
+	double gap;    // m along the path from the point before the first one
+	double speed;  // m/s
+};
+
+// Speeds of points 0.02 s apart that reach a target speed as fast as the
+// limits allow. The acceleration changes by at most max_jerk per second and
+// is brought back to 0 just in time to reach the target without overshooting
+// it, so the target can change from one point to the next.
+//
+// Behind a lead vehicle every point's target is lowered to the speed from
+// which the car still slows down to the lead's speed before closing in to
+// the following distance, braking at half max_decel so that the jerk limited
+// braking keeps up. Closer than that the target drops below the lead's speed.
+class VelocityProfile
+{
+public:
+	explicit VelocityProfile(const SpeedLimits &limits = default_speed_limits());
+
+	// n speeds in m/s continuing from speed v and acceleration a at the point
+	// before the first one. lead may be NULL. Returns the acceleration at
+	// the last point.
+	double plan(double v, double a, double target, const LeadVehicle *lead, int n, double *speeds) const;
+
+	const SpeedLimits &limits() const { return bounds; }
+
+	// distance kept to a lead vehicle at speed
+	static double follow_gap(double speed);
+
+private:
+	SpeedLimits bounds;
+};
+
+#endif /* VELOCITY_PROFILE_H */
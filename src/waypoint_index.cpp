@@ -0,0 +1,161 @@
+#include "waypoint_index.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+void WaypointIndex::build(const vector<double> &maps_x, const vector<double> &maps_y, double cell_size)
+{
+	xs = maps_x;
+	ys = maps_y;
+	cell = cell_size;
+
+	// an empty grid, closest() has nothing to return
+	if (xs.empty())
+	{
+		min_x = 0;
+		min_y = 0;
+		nx = 0;
+		ny = 0;
+		cell_start.assign(1, 0);
+		cell_items.clear();
+		return;
+	}
+
+	min_x = *min_element(xs.begin(), xs.end());
+	min_y = *min_element(ys.begin(), ys.end());
+	double max_x = *max_element(xs.begin(), xs.end());
+	double max_y = *max_element(ys.begin(), ys.end());
+
+	nx = (int)((max_x - min_x) / cell) + 1;
+	ny = (int)((max_y - min_y) / cell) + 1;
+
+	// counting sort of the waypoints into their cells
+	vector<int> cell_of(xs.size());
+	cell_start.assign(nx * ny + 1, 0);
+	for (int i = 0; i < (int)xs.size(); i++)
+	{
+		int cx = (int)((xs[i] - min_x) / cell);
+		int cy = (int)((ys[i] - min_y) / cell);
+		cell_of[i] = cy * nx + cx;
+		cell_start[cell_of[i] + 1]++;
+	}
+	for (int c = 0; c < nx * ny; c++)
+	{
+		cell_start[c + 1] += cell_start[c];
+	}
+
+	cell_items.resize(xs.size());
+	vector<int> fill(cell_start.begin(), cell_start.end() - 1);
+	for (int i = 0; i < (int)xs.size(); i++)
+	{
+		cell_items[fill[cell_of[i]]++] = i;
+	}
+}
+
+double WaypointIndex::dist2(int i, double x, double y) const
+{
+	double dx = xs[i] - x;
+	double dy = ys[i] - y;
+	return dx*dx + dy*dy;
+}
+
+int WaypointIndex::closest(double x, double y) const
+{
+	if (xs.empty())
+	{
+		return -1;
+	}
+
+	// the query cell may lie outside the grid, rings are clipped to the grid
+	int cx = (int)floor((x - min_x) / cell);
+	int cy = (int)floor((y - min_y) / cell);
+
+	int max_ring = max(max(cx, nx - 1 - cx), max(cy, ny - 1 - cy));
+
+	double best = 1e300;
+	int closestWaypoint = 0;
+
+	for (int r = 0; r <= max_ring; r++)
+	{
+		for (int gy = cy - r; gy <= cy + r; gy++)
+		{
+			if (gy < 0 || gy >= ny)
+			{
+				continue;
+			}
+			// interior rows only contribute the two edge cells of the ring
+			int step = (gy == cy - r || gy == cy + r) ? 1 : 2 * r;
+			for (int gx = cx - r; gx <= cx + r; gx += max(step, 1))
+			{
+				if (gx < 0 || gx >= nx)
+				{
+					continue;
+				}
+				int c = gy * nx + gx;
+				for (int k = cell_start[c]; k < cell_start[c + 1]; k++)
+				{
+					int i = cell_items[k];
+					double d = dist2(i, x, y);
+					if (d < best)
+					{
+						best = d;
+						closestWaypoint = i;
+					}
+				}
+			}
+		}
+
+		// everything beyond ring r is at least r cells away
+		if (best <= (r * cell) * (r * cell))
+		{
+			break;
+		}
+	}
+
+	return closestWaypoint;
+}
+
+int WaypointIndex::closest(double x, double y, int &hint) const
+{
+	int n = size();
+	if (hint < 0 || hint >= n)
+	{
+		hint = closest(x, y);
+		return hint;
+	}
+
+	// walk along the track from the last result while the distance shrinks
+	int i = hint;
+	double best = dist2(i, x, y);
+	while (true)
+	{
+		int next = (i + 1) % n;
+		int prev = (i - 1 + n) % n;
+		double d_next = dist2(next, x, y);
+		double d_prev = dist2(prev, x, y);
+		if (d_next < best && d_next <= d_prev)
+		{
+			i = next;
+			best = d_next;
+		}
+		else if (d_prev < best)
+		{
+			i = prev;
+			best = d_prev;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	// a local minimum far from the track may belong to another part of the loop
+	if (best > cell * cell)
+	{
+		i = closest(x, y);
+	}
+
+	hint = i;
+	return i;
+}
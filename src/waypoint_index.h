@@ -0,0 +1,43 @@
+#ifndef WAYPOINT_INDEX_H
+#define WAYPOINT_INDEX_H
+
+#include <vector>
+
+// Uniform grid over the map waypoints, built once at startup.
+// Answers "closest waypoint to (x,y)" without scanning the whole map.
+class WaypointIndex
+{
+public:
+	WaypointIndex() {}
+
+	// bucket the waypoints into square cells of cell_size meters
+	void build(const std::vector<double> &maps_x, const std::vector<double> &maps_y, double cell_size = 50.0);
+
+	int size() const { return (int)xs.size(); }
+
+	// exact nearest waypoint, searching grid rings outwards from the query
+	// cell. -1 when the index was built from no waypoints.
+	int closest(double x, double y) const;
+
+	// nearest waypoint continuing from the segment found on the last call.
+	// hint is read and updated; pass -1 when there is no previous result.
+	int closest(double x, double y, int &hint) const;
+
+private:
+	std::vector<double> xs;
+	std::vector<double> ys;
+
+	double cell;
+	double min_x;
+	double min_y;
+	int nx;
+	int ny;
+
+	// waypoint ids grouped per cell, cell c owns cell_items[cell_start[c] .. cell_start[c+1])
+	std::vector<int> cell_start;
+	std::vector<int> cell_items;
+
+	double dist2(int i, double x, double y) const;
+};
+
+#endif /* WAYPOINT_INDEX_H */
@@ -0,0 +1,94 @@
+#include "worker_pool.h"
+
+using namespace std;
+
+WorkerPool::WorkerPool(int threads)
+	: job(NULL), job_size(0), generation(0), busy_workers(0), stopping(false), next(0)
+{
+	for (int i = 1; i < threads; i++)
+	{
+		workers.push_back(thread(&WorkerPool::work, this));
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		lock_guard<mutex> guard(lock);
+		stopping = true;
+	}
+	work_ready.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+// takes task indices until none are left
+void WorkerPool::drain()
+{
+	int i;
+	while ((i = next.fetch_add(1)) < job_size)
+	{
+		(*job)(i);
+	}
+}
+
+void WorkerPool::work()
+{
+	long seen = 0;
+	while (true)
+	{
+		{
+			unique_lock<mutex> guard(lock);
+			work_ready.wait(guard, [&]() { return stopping || generation != seen; });
+			if (stopping)
+			{
+				return;
+			}
+			seen = generation;
+		}
+
+		drain();
+
+		{
+			lock_guard<mutex> guard(lock);
+			busy_workers--;
+		}
+		work_done.notify_one();
+	}
+}
+
+void WorkerPool::run(int n, const function<void(int)> &task)
+{
+	if (n <= 0)
+	{
+		return;
+	}
+	lock_guard<mutex> turn(caller);
+	if (workers.empty() || n == 1)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			task(i);
+		}
+		return;
+	}
+
+	{
+		lock_guard<mutex> guard(lock);
+		job = &task;
+		job_size = n;
+		next = 0;
+		busy_workers = (int)workers.size();
+		generation++;
+	}
+	work_ready.notify_all();
+
+	drain();
+
+	// the task must stay alive until every worker has left drain()
+	unique_lock<mutex> guard(lock);
+	work_done.wait(guard, [&]() { return busy_workers == 0; });
+	job = NULL;
+}
@@ -0,0 +1,48 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent threads for splitting one tick's work, like the evaluation of
+// many trajectory candidates, over the cores.
+class WorkerPool
+{
+public:
+	// threads counts the caller of run(), so threads - 1 workers are started
+	explicit WorkerPool(int threads);
+	~WorkerPool();
+
+	int size() const { return (int)workers.size() + 1; }
+
+	// task(i) for every i in [0, n), on the workers and the calling thread.
+	// Returns when all are done. Calls from several threads take turns.
+	void run(int n, const std::function<void(int)> &task);
+
+private:
+	std::vector<std::thread> workers;
+
+	std::mutex caller; // one run() at a time
+	std::mutex lock;
+	std::condition_variable work_ready;
+	std::condition_variable work_done;
+
+	const std::function<void(int)> *job;
+	int job_size;
+	long generation;  // bumped for every run(), workers wait for a new one
+	int busy_workers;
+	bool stopping;
+	std::atomic<int> next;
+
+	void work();
+	void drain();
+
+	WorkerPool(const WorkerPool &);
+	WorkerPool &operator=(const WorkerPool &);
+};
+
+#endif /* WORKER_POOL_H */